@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Minimal harness shared by the benchmarks.
+ * Every result is printed as one JSON object per line, e.g.
+ * {"benchmark":"publish_to_callback","threads":1,"ops":100000,
+ *  "ops_per_sec":512345.6,"p50_ns":1800,"p99_ns":5300,"p999_ns":21000}
+ * Percentiles are null if the benchmark doesn't record latencies.
+ */
+
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Result of one benchmark run
+ */
+struct Result {
+    std::string name; ///< name of the benchmark, including its parameters
+    int threads; ///< number of threads that generated load
+    long operations; ///< number of operations performed
+    Clock::duration elapsed; ///< wall clock time of all operations
+    std::vector<std::int64_t> latencies; ///< latency samples in ns - may be empty
+};
+
+/**
+ * @param sorted sorted latency samples
+ * @param fraction the percentile as a fraction, e.g. 0.99
+ * @return the percentile as a JSON value
+ */
+inline std::string percentile(const std::vector<std::int64_t>& sorted,
+        double fraction) {
+    if (sorted.empty()) {
+        return "null";
+    }
+    std::size_t index = static_cast<std::size_t>(fraction * (sorted.size() - 1)
+            + 0.5);
+    return std::to_string(sorted[index]);
+}
+
+/**
+ * Prints a Result as a JSON line to stdout.
+ *
+ * @param result the Result - its latencies get sorted
+ */
+inline void report(Result& result) {
+    std::sort(result.latencies.begin(), result.latencies.end());
+    double seconds =
+            std::chrono::duration_cast<std::chrono::duration<double>>(
+                    result.elapsed).count();
+
+    std::cout << "{\"benchmark\":\"" << result.name << "\",\"threads\":"
+            << result.threads << ",\"ops\":" << result.operations
+            << ",\"ops_per_sec\":" << result.operations / seconds
+            << ",\"p50_ns\":" << percentile(result.latencies, 0.5)
+            << ",\"p99_ns\":" << percentile(result.latencies, 0.99)
+            << ",\"p999_ns\":" << percentile(result.latencies, 0.999) << "}"
+            << std::endl;
+}
+
+/**
+ * @param start start of the measured interval
+ * @return nanoseconds elapsed since start
+ */
+inline std::int64_t nanosSince(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start).count();
+}
+
+} /* namespace bench */
+
+#endif /* BENCH_BENCH_H_ */
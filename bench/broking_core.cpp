@@ -0,0 +1,222 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Microbenchmarks for the core operations of the broking module:
+ * - publish to callback delivery
+ * - publish to BufferedSubscription::getMessage
+ * - fan-out to 1/10/100 subscribers
+ * - ThreadSafeQueue enqueue/dequeue under contention
+ * - Broker::getChannel lookups
+ */
+
+#include "bench.h"
+#include "broking/broking.h"
+#include "broking/ThreadSafeQueue.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench::Clock;
+using bench::Result;
+
+/**
+ * Number of messages per latency benchmark
+ */
+constexpr long ITERATIONS = 100000;
+
+/**
+ * Number of operations per thread in the contention benchmarks
+ */
+constexpr long OPERATIONS_PER_THREAD = 200000;
+
+/**
+ * Publishes one message at a time and waits until the callback received it.
+ *
+ * @param inlineDispatch true to dispatch on the publishing thread
+ * @param name name of the benchmark
+ */
+static void publishToCallback(bool inlineDispatch, const std::string& name) {
+    Channel<long> channel("bench.core.callback");
+    channel.setInlineDispatch(inlineDispatch);
+    std::atomic<long> received(-1);
+    channel.subscribe([&received](long i) {
+        received.store(i, std::memory_order_release);
+    }, true);
+
+    Result result { name, 1, ITERATIONS, Clock::duration(), { } };
+    result.latencies.reserve(ITERATIONS);
+
+    auto start = Clock::now();
+    for (long i = 0; i < ITERATIONS; ++i) {
+        auto sent = Clock::now();
+        channel.publish(i);
+        while (received.load(std::memory_order_acquire) != i) {
+        }
+        result.latencies.push_back(bench::nanosSince(sent));
+    }
+    result.elapsed = Clock::now() - start;
+    bench::report(result);
+}
+
+/**
+ * Publishes one message at a time and reads it from a buffer.
+ *
+ * @param type the kind of buffer
+ * @param name name of the benchmark
+ * @param wait how the worker and the reader wait
+ */
+static void publishToBuffer(BufferType type, const std::string& name,
+        WaitStrategy wait = WaitStrategy()) {
+    Executor executor(1);
+    executor.setWaitStrategy(wait);
+    Channel<long> channel("bench.core.buffer", executor);
+    auto buffer = channel.subscribe(DEFAULT_BUFFERSIZE, type,
+            OverflowPolicy<long>(), wait);
+
+    Result result { name, 1, ITERATIONS, Clock::duration(), { } };
+    result.latencies.reserve(ITERATIONS);
+
+    auto start = Clock::now();
+    for (long i = 0; i < ITERATIONS; ++i) {
+        auto sent = Clock::now();
+        channel.publish(i);
+        buffer.getMessage();
+        result.latencies.push_back(bench::nanosSince(sent));
+    }
+    result.elapsed = Clock::now() - start;
+    bench::report(result);
+}
+
+/**
+ * Publishes one message at a time and waits until all subscribers received it.
+ *
+ * @param subscribers number of callback subscribers
+ */
+static void fanOut(int subscribers) {
+    Channel<long> channel("bench.core.fanout");
+    std::atomic<long> received(0);
+    for (int s = 0; s < subscribers; ++s) {
+        channel.subscribe([&received](long) {
+            received.fetch_add(1, std::memory_order_release);
+        }, true);
+    }
+
+    long iterations = ITERATIONS / subscribers * 10;
+    Result result { "fanout/" + std::to_string(subscribers), 1, iterations,
+            Clock::duration(), { } };
+    result.latencies.reserve(iterations);
+
+    auto start = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        auto sent = Clock::now();
+        channel.publish(i);
+        while (received.load(std::memory_order_acquire)
+                != (i + 1) * subscribers) {
+        }
+        result.latencies.push_back(bench::nanosSince(sent));
+    }
+    result.elapsed = Clock::now() - start;
+    bench::report(result);
+}
+
+/**
+ * Threads that enqueue and dequeue pairs on a shared ThreadSafeQueue.
+ *
+ * @param threadCount number of threads
+ */
+static void queueContention(int threadCount) {
+    ThreadSafeQueue<long> queue(threadCount);
+    std::vector<std::vector<std::int64_t>> latencies(threadCount);
+    std::vector<std::thread> threads;
+
+    auto start = Clock::now();
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&queue, &latencies, t]() {
+            latencies[t].reserve(OPERATIONS_PER_THREAD);
+            for (long i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+                auto sent = Clock::now();
+                queue.enqueue(i);
+                queue.dequeue();
+                latencies[t].push_back(bench::nanosSince(sent));
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    Result result { "threadsafequeue_enqueue_dequeue", threadCount, threadCount
+            * OPERATIONS_PER_THREAD, Clock::now() - start, { } };
+    for (auto&& samples : latencies) {
+        result.latencies.insert(result.latencies.end(), samples.begin(),
+                samples.end());
+    }
+    bench::report(result);
+}
+
+/**
+ * Threads that look up existing channels by name.
+ *
+ * @param threadCount number of threads
+ */
+static void channelLookup(int threadCount) {
+    std::vector<std::string> names;
+    for (int i = 0; i < 100; ++i) {
+        names.push_back("bench.core.lookup." + std::to_string(i));
+        GET_CHANNEL(int, names.back());
+    }
+
+    std::vector<std::vector<std::int64_t>> latencies(threadCount);
+    std::vector<std::thread> threads;
+
+    auto start = Clock::now();
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&names, &latencies, t]() {
+            latencies[t].reserve(OPERATIONS_PER_THREAD);
+            for (long i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+                auto sent = Clock::now();
+                GET_CHANNEL(int, names[i % names.size()]);
+                latencies[t].push_back(bench::nanosSince(sent));
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    Result result { "broker_getchannel", threadCount, threadCount
+            * OPERATIONS_PER_THREAD, Clock::now() - start, { } };
+    for (auto&& samples : latencies) {
+        result.latencies.insert(result.latencies.end(), samples.begin(),
+                samples.end());
+    }
+    bench::report(result);
+}
+
+int main() {
+    int maxThreads = std::max(4u, std::thread::hardware_concurrency());
+
+    publishToCallback(false, "publish_to_callback");
+    publishToCallback(true, "publish_to_callback/inline");
+    publishToBuffer(BufferType::LOCKING, "publish_to_getmessage/locking");
+    publishToBuffer(BufferType::SPSC, "publish_to_getmessage/spsc");
+    publishToBuffer(BufferType::SPSC, "publish_to_getmessage/spsc_spin_park",
+            WaitKind::SPIN_PARK);
+    for (int subscribers : { 1, 10, 100 }) {
+        fanOut(subscribers);
+    }
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        queueContention(threads);
+    }
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        channelLookup(threads);
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Measures the throughput of chains of channels whose callbacks publish to
+ * the next channel, with more channels in the chain than workers in the pool.
+ * Callbacks block their worker while the next publishing buffer is full, so
+ * this also checks that the pool doesn't deadlock - it would never finish.
+ */
+
+#include "bench.h"
+#include "broking/broking.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of messages published to the first channel
+ */
+constexpr long MESSAGES = 20000;
+
+/**
+ * Number of messages every callback publishes to the next channel
+ */
+constexpr long REPUBLISH = 50;
+
+using bench::Clock;
+
+/**
+ * Publishes to the first channel of a chain and waits until the last channel
+ * received all messages.
+ *
+ * @param name name of the benchmark
+ * @param length number of channels in the chain
+ * @param republish number of messages every callback publishes to the next
+ *                  channel
+ * @param executor runs the processing of all channels
+ */
+static void measure(const std::string& name, std::size_t length,
+        long republish, Executor& executor) {
+    std::vector<std::unique_ptr<Channel<long>>> chain;
+    for (std::size_t i = 0; i < length; ++i) {
+        chain.emplace_back(
+                new Channel<long>("bench.chain." + name + std::to_string(i),
+                        executor));
+    }
+
+    std::vector<Subscription> subscriptions;
+    for (std::size_t i = 0; i + 1 < length; ++i) {
+        Channel<long>& next = *chain[i + 1];
+        subscriptions.push_back(chain[i]->subscribe([&next, republish](long message) {
+            for (long r = 0; r < republish; ++r) {
+                next.publish(message);
+            }
+        }));
+    }
+
+    long total = MESSAGES;
+    for (std::size_t i = 0; i + 1 < length; ++i) {
+        total *= republish;
+    }
+    std::atomic<long> received(0);
+    subscriptions.push_back(chain.back()->subscribe([&received](long) {
+        received.fetch_add(1, std::memory_order_relaxed);
+    }));
+
+    auto start = Clock::now();
+    for (long i = 0; i < MESSAGES; ++i) {
+        chain.front()->publish(i);
+    }
+    while (received.load(std::memory_order_relaxed) != total) {
+        std::this_thread::yield();
+    }
+
+    bench::Result result { "chained_publish/" + name, 1, total, Clock::now()
+            - start, { } };
+    bench::report(result);
+}
+
+int main() {
+    // a chain that is longer than the pool
+    Executor single(1);
+    measure("single_worker", 2, REPUBLISH, single);
+
+    std::size_t workers = Executor::defaultWorkerCount();
+    Executor pool(workers);
+    measure("chain_above_pool", workers + 2, 2, pool);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Measures concurrent Broker::getChannel throughput for 1 to N threads,
+ * compared to a std::map behind a single mutex.
+ */
+
+#include "bench.h"
+#include "broking/broking.h"
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of distinct channels that are looked up
+ */
+constexpr int CHANNEL_COUNT = 1000;
+
+/**
+ * Number of lookups every thread performs
+ */
+constexpr int LOOKUPS_PER_THREAD = 500000;
+
+using bench::Clock;
+
+/**
+ * Runs threads that look up channels concurrently and reports the throughput.
+ *
+ * @param name name of the benchmark
+ * @param threadCount number of threads
+ * @param lookup looks up the channel with the given name
+ * @param names the names to look up
+ */
+static void measure(const std::string& name, int threadCount,
+        std::function<void(const std::string&)> lookup,
+        const std::vector<std::string>& names) {
+    std::vector<std::thread> threads;
+
+    auto start = Clock::now();
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&lookup, &names, t]() {
+            for (int i = 0; i < LOOKUPS_PER_THREAD; ++i) {
+                lookup(names[(i * 7 + t) % names.size()]);
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    bench::Result result { name, threadCount, static_cast<long>(threadCount)
+            * LOOKUPS_PER_THREAD, Clock::now() - start, { } };
+    bench::report(result);
+}
+
+int main() {
+    int maxThreads = std::max(16u, std::thread::hardware_concurrency());
+
+    std::vector<std::string> names;
+    for (int i = 0; i < CHANNEL_COUNT; ++i) {
+        names.push_back("bench.lookup." + std::to_string(i));
+        GET_CHANNEL(int, names.back());
+    }
+
+    // what the Broker used to do
+    std::mutex mtxBaseline;
+    std::map<std::string, int> baseline;
+    for (auto&& name : names) {
+        baseline[name] = 0;
+    }
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        measure("channel_lookup/map_mutex", threads, [&mtxBaseline, &baseline](const std::string& name) {
+            std::lock_guard<std::mutex> lock(mtxBaseline);
+            volatile int value = baseline.find(name)->second;
+            (void) value;
+        }, names);
+
+        measure("channel_lookup/broker", threads, [](const std::string& name) {
+            volatile Channel<int>* channel = &GET_CHANNEL(int, name);
+            (void) channel;
+        }, names);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Measures a buffered subscriber that is only interested in every 20th
+ * message - once filtering on the consumer thread and once with a filter
+ * that is evaluated before enqueue.
+ */
+
+#include "bench.h"
+#include "broking/broking.h"
+
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of messages per run
+ */
+constexpr long MESSAGES = 200000;
+
+/**
+ * Only every SELECTIVITY-th message is of interest
+ */
+constexpr long SELECTIVITY = 20;
+
+/**
+ * Size of the buffer
+ */
+constexpr int BUFFER_SIZE = 1024;
+
+using bench::Clock;
+
+/**
+ * Message with a payload that is expensive to copy
+ */
+struct Message {
+    long sequence; ///< number of the message
+    Clock::time_point published; ///< when the message was published
+    std::array<char, 256> payload; ///< payload
+};
+
+/**
+ * @param message the message
+ * @return true if the subscriber is interested in message
+ */
+static bool interesting(const Message& message) {
+    return message.sequence % SELECTIVITY == 0
+            || message.sequence == MESSAGES - 1;
+}
+
+/**
+ * Publishes all messages and waits until the consumer got the last one.
+ *
+ * @param name name of the benchmark
+ * @param filterOnDispatch true to pass the filter to subscribe
+ */
+static void measure(const std::string& name, bool filterOnDispatch) {
+    auto& channel = GET_CHANNEL(Message, "bench.filtered." + name);
+
+    auto policy = OverflowPolicy<Message>::block(std::chrono::seconds(1));
+    auto subscription =
+            filterOnDispatch ?
+                    channel.subscribe(interesting, BUFFER_SIZE,
+                            BufferType::LOCKING, policy) :
+                    channel.subscribe(BUFFER_SIZE, BufferType::LOCKING,
+                            policy);
+
+    std::vector<std::int64_t> latencies;
+    latencies.reserve(MESSAGES / SELECTIVITY + 1);
+    std::thread consumer([&]() {
+        while (true) {
+            Message message = subscription.getMessage();
+            if (!interesting(message)) {
+                continue;
+            }
+            latencies.push_back(bench::nanosSince(message.published));
+            if (message.sequence == MESSAGES - 1) {
+                return;
+            }
+        }
+    });
+
+    auto start = Clock::now();
+    for (long i = 0; i < MESSAGES; ++i) {
+        channel.publish(Message { i, Clock::now(), { } });
+    }
+    consumer.join();
+    auto elapsed = Clock::now() - start;
+    channel.unsubscribe(subscription);
+
+    bench::Result result { "filtered_subscription/" + name, 2, MESSAGES,
+            elapsed, std::move(latencies) };
+    bench::report(result);
+}
+
+int main() {
+    measure("consumer_side", false);
+    measure("dispatch_side", true);
+}
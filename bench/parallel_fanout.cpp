@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Measures the latency of a message on a wide channel (many callbacks that do
+ * a little work each) - sequential and with parallel fan-out.
+ */
+
+#include "bench.h"
+#include "broking/broking.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * Number of callback subscribers
+ */
+constexpr int SUBSCRIBERS = 300;
+
+/**
+ * Number of published messages per run
+ */
+constexpr long MESSAGES = 2000;
+
+/**
+ * Time every callback spends on a message
+ */
+constexpr std::chrono::nanoseconds WORK_PER_CALLBACK(500);
+
+using bench::Clock;
+
+/**
+ * Publishes one message at a time and waits until all subscribers received it.
+ *
+ * @param partitions number of partitions - 1 dispatches sequentially
+ */
+static void measure(std::size_t partitions) {
+    Executor executor(partitions);
+    Channel<long> channel("bench.fanout", executor);
+    channel.setParallelFanOut(partitions);
+
+    std::atomic<long> received(0);
+    for (int s = 0; s < SUBSCRIBERS; ++s) {
+        channel.subscribe([&received](long) {
+            auto start = Clock::now();
+            while (Clock::now() - start < WORK_PER_CALLBACK) {
+                // busy subscriber
+            }
+            received.fetch_add(1, std::memory_order_release);
+        }, true);
+    }
+
+    bench::Result result { "parallel_fanout/" + std::to_string(SUBSCRIBERS)
+            + "/partitions:" + std::to_string(partitions), 1, MESSAGES,
+            Clock::duration(), { } };
+    result.latencies.reserve(MESSAGES);
+
+    auto start = Clock::now();
+    for (long i = 0; i < MESSAGES; ++i) {
+        auto sent = Clock::now();
+        channel.publish(i);
+        while (received.load(std::memory_order_acquire)
+                != (i + 1) * SUBSCRIBERS) {
+        }
+        result.latencies.push_back(bench::nanosSince(sent));
+    }
+    result.elapsed = Clock::now() - start;
+    bench::report(result);
+}
+
+int main() {
+    std::size_t maxPartitions = std::max(4u, std::thread::hardware_concurrency());
+    for (std::size_t partitions = 1; partitions <= maxPartitions; partitions *=
+            2) {
+        measure(partitions);
+    }
+}
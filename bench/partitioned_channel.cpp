@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Measures the throughput of a PartitionedChannel with a busy subscriber for
+ * 1 to N partitions.
+ */
+
+#include "bench.h"
+#include "broking/broking.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of messages every producer publishes
+ */
+constexpr long MESSAGES_PER_PRODUCER = 20000;
+
+/**
+ * Number of distinct keys
+ */
+constexpr long KEYS = 1024;
+
+/**
+ * Coprime to KEYS, so every producer cycles through all keys
+ */
+constexpr long FACTOR = 7919;
+
+/**
+ * Time the subscriber spends on every message
+ */
+constexpr std::chrono::nanoseconds WORK_PER_MESSAGE(1000);
+
+using bench::Clock;
+
+/**
+ * Publishes from one producer per partition and waits until all messages
+ * were received.
+ *
+ * @param partitionCount number of partitions
+ */
+static void measure(std::size_t partitionCount) {
+    Executor executor(partitionCount);
+    PartitionedChannel<long> channel("bench.partitioned", partitionCount,
+            [](long message) {return message % KEYS;}, executor);
+
+    std::atomic<long> received(0);
+    auto subscriptions = channel.subscribe([&received](long) {
+        auto start = Clock::now();
+        while (Clock::now() - start < WORK_PER_MESSAGE) {
+            // busy subscriber
+        }
+        received.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    long total = static_cast<long>(partitionCount) * MESSAGES_PER_PRODUCER;
+    std::vector<std::thread> producers;
+
+    auto start = Clock::now();
+    for (std::size_t p = 0; p < partitionCount; ++p) {
+        producers.emplace_back([&channel, p]() {
+            for (long i = 0; i < MESSAGES_PER_PRODUCER; ++i) {
+                channel.publish((i * FACTOR + static_cast<long>(p)) % KEYS);
+            }
+        });
+    }
+    for (auto&& producer : producers) {
+        producer.join();
+    }
+    while (received.load(std::memory_order_relaxed) != total) {
+        std::this_thread::yield();
+    }
+
+    bench::Result result { "partitioned_channel/partitions:"
+            + std::to_string(partitionCount), static_cast<int>(partitionCount),
+            total, Clock::now() - start, { } };
+    bench::report(result);
+}
+
+int main() {
+    std::size_t maxPartitions = std::max(4u, std::thread::hardware_concurrency());
+    for (std::size_t partitions = 1; partitions <= maxPartitions; partitions *=
+            2) {
+        measure(partitions);
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Measures the latency of control messages (Severity::ERROR) on a channel that
+ * is flooded with telemetry (Severity::WARNING) - once for every
+ * LaneScheduling.
+ */
+
+#include "bench.h"
+#include "broking/broking.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of control messages per run
+ */
+constexpr int CONTROL_MESSAGES = 20000;
+
+/**
+ * Number of threads flooding the channel
+ */
+constexpr int FLOOD_THREADS = 2;
+
+/**
+ * Time the subscriber spends on every message
+ */
+constexpr std::chrono::nanoseconds WORK_PER_MESSAGE(1000);
+
+/**
+ * Time between two control messages
+ */
+constexpr std::chrono::microseconds CONTROL_INTERVAL(50);
+
+using bench::Clock;
+
+/**
+ * Message that is either telemetry or a timestamped control message
+ */
+struct Message {
+    bool control; ///< true for control messages
+    Clock::time_point published; ///< when a control message was published
+};
+
+/**
+ * Runs the flood and the control thread and reports the control latency.
+ *
+ * @param name name of the benchmark
+ * @param scheduling the LaneScheduling of the channel
+ */
+static void measure(const std::string& name, LaneScheduling scheduling) {
+    auto& channel = GET_CHANNEL(Message, "bench.lanes." + name);
+    channel.setLaneScheduling(scheduling);
+
+    std::vector<std::int64_t> latencies;
+    latencies.reserve(CONTROL_MESSAGES);
+    std::atomic<int> received(0);
+
+    auto subscription = channel.subscribe([&](Message message) {
+        auto start = Clock::now();
+        while (Clock::now() - start < WORK_PER_MESSAGE) {
+            // busy subscriber
+        }
+        if (message.control) {
+            latencies.push_back(bench::nanosSince(message.published));
+            received.fetch_add(1, std::memory_order_release);
+        }
+    });
+
+    std::atomic<bool> flooding(true);
+    std::vector<std::thread> flood;
+    for (int i = 0; i < FLOOD_THREADS; ++i) {
+        flood.emplace_back([&]() {
+            while (flooding.load(std::memory_order_relaxed)) {
+                channel.publish(Message { false, Clock::time_point() },
+                        Severity::WARNING);
+            }
+        });
+    }
+
+    auto start = Clock::now();
+    auto next = start;
+    for (int i = 0; i < CONTROL_MESSAGES; ++i) {
+        next += CONTROL_INTERVAL;
+        while (Clock::now() < next) {
+            // pace the control messages
+        }
+        channel.publish(Message { true, Clock::now() }, Severity::ERROR);
+    }
+    while (received.load(std::memory_order_acquire) < CONTROL_MESSAGES) {
+        std::this_thread::yield();
+    }
+    auto elapsed = Clock::now() - start;
+
+    flooding = false;
+    for (auto&& thread : flood) {
+        thread.join();
+    }
+    channel.unsubscribe(subscription);
+
+    bench::Result result { "priority_lanes/" + name, FLOOD_THREADS + 1,
+            CONTROL_MESSAGES, elapsed, std::move(latencies) };
+    bench::report(result);
+}
+
+int main() {
+    measure("fifo", LaneScheduling::FIFO);
+    measure("strict", LaneScheduling::STRICT);
+    measure("weighted", LaneScheduling::WEIGHTED);
+}
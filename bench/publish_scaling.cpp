@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Measures publish throughput for 1 to N producer threads - once for the
+ * publishing queue implementations on their own and once through a Channel.
+ */
+
+#include "bench.h"
+#include "broking/broking.h"
+#include "broking/MPMCQueue.h"
+#include "broking/ThreadSafeQueue.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/**
+ * Number of messages every producer publishes
+ */
+constexpr int MESSAGES_PER_PRODUCER = 200000;
+
+using bench::Clock;
+using Message = std::tuple<int, Severity>;
+
+/**
+ * Runs producers threads that publish concurrently and reports the throughput.
+ *
+ * @param name name of the benchmark
+ * @param producers number of producer threads
+ * @param publish publishes one message
+ * @param drain consumes exactly the given number of messages
+ */
+static void measure(const std::string& name, int producers,
+        std::function<void(int)> publish, std::function<void(long)> drain) {
+    long total = static_cast<long>(producers) * MESSAGES_PER_PRODUCER;
+    std::vector<std::thread> threads;
+
+    auto start = Clock::now();
+    std::thread consumer(drain, total);
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&publish]() {
+            for (int i = 0; i < MESSAGES_PER_PRODUCER; ++i) {
+                publish(i);
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+    consumer.join();
+
+    bench::Result result { name, producers, total, Clock::now() - start, { } };
+    bench::report(result);
+}
+
+int main() {
+    int maxProducers = std::max(16u, std::thread::hardware_concurrency());
+
+    for (int producers = 1; producers <= maxProducers; producers *= 2) {
+        ThreadSafeQueue<Message> locking(PUBLISHING_QUEUE_SIZE);
+        measure("publish_scaling/threadsafequeue", producers, [&locking](int i) {
+            locking.enqueue(std::make_tuple(i, Severity::ERROR));
+        }, [&locking](long count) {
+            for (long i = 0; i < count; ++i) {
+                locking.dequeue();
+            }
+        });
+
+        MPMCQueue<Message> lockFree(PUBLISHING_QUEUE_SIZE);
+        measure("publish_scaling/mpmcqueue", producers, [&lockFree](int i) {
+            lockFree.enqueue(std::make_tuple(i, Severity::ERROR));
+        }, [&lockFree](long count) {
+            for (long i = 0; i < count; ++i) {
+                lockFree.dequeue();
+            }
+        });
+
+        std::atomic<long> received(0);
+        Channel<int> channel("bench.publish");
+        channel.subscribe([&received](int) {++received;}, true);
+        measure("publish_scaling/channel", producers, [&channel](int i) {
+            channel.publish(i);
+        }, [&received](long count) {
+            while (received < count) {
+                std::this_thread::yield();
+            }
+        });
+    }
+}
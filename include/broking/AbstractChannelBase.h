@@ -14,6 +14,9 @@
 #ifndef BROKING_ABSTRACTCHANNELBASE_H_
 #define BROKING_ABSTRACTCHANNELBASE_H_
 
+#include "broking/ChannelStats.h"
+#include "broking/LatencyHistogram.h"
+
 namespace broking {
 
 // Forward declare
@@ -35,6 +38,10 @@ public:
     }
 
     virtual void unsubscribe(const Subscription& subscription) = 0;
+
+    virtual void setLatencyTracking(bool enable) = 0;
+    virtual ChannelLatency getLatency() = 0;
+    virtual ChannelStats getStats() = 0;
 };
 
 } // namespace broking
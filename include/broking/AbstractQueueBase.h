@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_ABSTRACTQUEUEBASE_H_
+#define BROKING_ABSTRACTQUEUEBASE_H_
+
+#include "broking/WaitStrategy.h"
+#include "util/optional.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace broking {
+
+/**
+ * Callback used by queues if no event callback is set
+ */
+static auto DO_NOTHING_CALLBACK = [](){};
+
+/**
+ * Abstract Base class to unify all queues that can buffer a subscription.
+ *
+ * @author Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename T> class AbstractQueueBase {
+public:
+
+    /**
+     * Virtual Destructor
+     */
+    virtual ~AbstractQueueBase() {
+    }
+
+    virtual bool canEnqueue() = 0;
+    virtual bool canDequeue() = 0;
+    virtual std::size_t size() = 0;
+    virtual std::size_t capacity() = 0;
+
+    virtual bool tryEnqueue(T message) = 0;
+    virtual bool enqueueUntil(T message,
+            std::chrono::steady_clock::time_point deadline) = 0;
+
+    virtual std::experimental::optional<T> tryDequeue() = 0;
+    virtual T dequeue() = 0;
+    virtual std::experimental::optional<T> dequeueUntil(
+            std::chrono::steady_clock::time_point deadline) = 0;
+
+    virtual std::size_t drain(const std::function<void(T&&)>& sink,
+            std::size_t max) = 0;
+    virtual std::size_t drainUntil(const std::function<void(T&&)>& sink,
+            std::chrono::steady_clock::time_point deadline, std::size_t max) = 0;
+
+    virtual void setOnNewElement(std::function<void(void)> callback) = 0;
+    virtual void unsetOnNewElement() = 0;
+
+    virtual void setWaitStrategy(WaitStrategy strategy) = 0;
+};
+
+} // namespace broking
+
+#endif /* BROKING_ABSTRACTQUEUEBASE_H_ */
+/** @} */
@@ -15,11 +15,21 @@
 #define BROKING_BROKER_H_
 
 #include "broking/Channel.h"
-#include <string>
-#include <map>
+#include "broking/ChannelRegistry.h"
+#include "broking/ChannelStats.h"
+#include "broking/Executor.h"
+#include "broking/LatencyHistogram.h"
+#include "broking/Topic.h"
+#include "broking/TopicTrie.h"
+#include "broking/WildcardSubscription.h"
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <mutex>
+#include <string>
 #include <stdexcept>
+#include <typeindex>
+#include <utility>
+#include <vector>
 
 namespace broking {
 
@@ -31,8 +41,9 @@ namespace broking {
  */
 class Broker {
 private:
-    std::mutex mtxChannelAccess; ///< mutex to protect access to the channels
-    std::map<std::string, std::unique_ptr<AbstractChannelBase>> channels; ///< stores the channels
+    Executor executor; ///< runs the processing of all channels - must outlive them
+    ChannelRegistry channels; ///< stores the channels
+    TopicTrie topics; ///< indexes the channel names for wildcard subscriptions
 
 public:
     static Broker& getBroker(); // Singleton
@@ -71,7 +82,19 @@ public:
      */
     virtual ~Broker() = default;
 
-    template<typename T> Channel<T>& getChannel(std::string id);
+    Executor& getExecutor();
+
+    void setLatencyTracking(bool enable);
+    std::vector<ChannelLatency> getLatencies();
+    std::vector<ChannelStats> getStats();
+
+    template<typename T> Channel<T>& getChannel(const std::string& id);
+    template<typename T, std::uint64_t Hash> Channel<T>& getChannel(
+            const Topic<T, Hash>& topic);
+
+    template<typename T> WildcardSubscription subscribePattern(
+            const std::string& pattern,
+            std::function<void(const std::string&, T)> callback);
 };
 
 /**
@@ -85,24 +108,107 @@ public:
  * @throws std::logic_error if requesting a channel that was created with another T
  */
 template<typename T>
-inline Channel<T>& Broker::getChannel(std::string id) {
-    // Thread safety
-    std::lock_guard<std::mutex> lock(mtxChannelAccess);
-
-    auto result = channels.find(id);
-    if (result == channels.end()) {
-        auto channel = std::unique_ptr<AbstractChannelBase>(new Channel<T>(id));
-        channels[id] = std::move(channel);
+inline Channel<T>& Broker::getChannel(const std::string& id) {
+    // lock-free unless the channel has to be created
+    ChannelRegistry::Entry& entry = channels.findOrCreate(id, typeid(T),
+            [this, &id]() {
+                std::unique_ptr<Channel<T>> channel(new Channel<T>(id, executor));
+                // attach the matching wildcard subscriptions before any other
+                // thread can get the channel
+                topics.addChannel(id, typeid(T), *channel);
+                return channel.release();
+            });
+
+    // the stored AbstractChannelBase* is only a Channel<T>* if the types match
+    if (entry.type != typeid(T)) {
+        throw std::logic_error(
+                "Failed to cast - Please ensure that the types match!!");
     }
+    return *static_cast<Channel<T>*>(entry.channel.get());
+}
 
-    // cast the stored AbstratChannelBase* to a usable Channel<T>*
-    Channel<T>* pointer = dynamic_cast<Channel<T>*>(channels[id].get());
-    if (!pointer) {
-        // dynamic_cast return nullptr if casting doesn't work.
+/**
+ * Get a reference to the channel described by a Topic.
+ * The channel is looked up by name only on the first call for this topic,
+ * all subsequent calls just return the cached reference.
+ *
+ * @param topic the Topic of the Channel
+ *
+ * @return reference to the Channel<T> that corresponds to the Topic
+ *
+ * @throws std::logic_error if the channel was already created with another T
+ * @throws std::logic_error if another topic of type T with the same name hash
+ *                          was resolved first
+ */
+template<typename T, std::uint64_t Hash>
+inline Channel<T>& Broker::getChannel(const Topic<T, Hash>& topic) {
+    /**
+     * The channel that was resolved first and the name it was resolved for
+     */
+    struct Resolved {
+        Channel<T>& channel; ///< the channel
+        const char* name; ///< the name of the topic it was resolved for
+    };
+
+    // one cache per type and name hash - initialized thread safe on first use
+    static const Resolved resolved { getChannel<T>(topic.name), topic.name };
+
+    // different names can have the same hash - only compare the names if the
+    // topic doesn't use the same literal
+    if (topic.name != resolved.name
+            && resolved.channel.getName() != topic.name) {
         throw std::logic_error(
-                "Failed to cast - Please ensure that the types match!!");
+                "Topic \"" + std::string(topic.name)
+                        + "\" has the same hash as \""
+                        + resolved.channel.getName()
+                        + "\" - Please rename one of them!!");
     }
-    return *pointer;
+    return resolved.channel;
+}
+
+/**
+ * Subscribe a callback to all channels whose name matches a pattern - both
+ * existing ones and the ones created later.
+ *
+ * Channel names are split into levels at the dots. In the pattern, `*` matches
+ * exactly one level and `#` (only as the last level) any number of levels, so
+ * `sensors.*.temperature` matches `sensors.kitchen.temperature` and
+ * `sensors.#` matches `sensors` and everything below it. Matching channels of
+ * another type than T are skipped.
+ *
+ * @param pattern the pattern
+ * @param callback gets the name of the channel and the message - called from
+ *                 the workers of several channels at once, so it has to be
+ *                 thread safe
+ *
+ * @return WildcardSubscription that unsubscribes from all matching channels
+ *         when it is destroyed
+ *
+ * @throws std::logic_error if `#` isn't the last level of the pattern
+ */
+template<typename T>
+inline WildcardSubscription Broker::subscribePattern(const std::string& pattern,
+        std::function<void(const std::string&, T)> callback) {
+    auto channels = std::make_shared<WildcardSubscription::Channels>();
+
+    // called while the trie is locked - one call per matching channel
+    int id = topics.addPattern(pattern,
+            [channels, callback](const TopicTrie::ChannelInfo& info) {
+                if (info.type != typeid(T)) {
+                    return;
+                }
+                std::vector<Subscription>& subscriptions = channels->subscriptions;
+                // once subscribed, storing the Subscription must not fail
+                subscriptions.reserve(subscriptions.size() + 1);
+
+                std::string name = info.name;
+                Channel<T>& channel = *static_cast<Channel<T>*>(info.channel);
+                subscriptions.push_back(channel.subscribe([callback, name](T message) {
+                                    callback(name, std::move(message));
+                                }));
+                channels->count.store(subscriptions.size(), std::memory_order_relaxed);
+            });
+    return WildcardSubscription(topics, pattern, id, std::move(channels));
 }
 
 } /* namespace broking */
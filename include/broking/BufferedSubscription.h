@@ -14,9 +14,13 @@
 #ifndef BROKING_BUFFEREDSUBSCRIPTION_H_
 #define BROKING_BUFFEREDSUBSCRIPTION_H_
 
+#include "broking/AbstractQueueBase.h"
 #include "broking/Subscription.h"
-#include "broking/ThreadSafeQueue.h"
+#include "util/optional.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 
@@ -30,9 +34,9 @@ namespace broking {
  */
 template<typename T> class BufferedSubscription: public Subscription {
 	// Alias to make code shorter
-	using QueuePtr = std::shared_ptr<ThreadSafeQueue<T>>;
+	using QueuePtr = std::shared_ptr<AbstractQueueBase<T>>;
 private:
-	QueuePtr queue; ///< the ThreadSafeQueue<T> buffering the incoming messages.
+	QueuePtr queue; ///< the queue buffering the incoming messages.
 public:
 	BufferedSubscription(Subscription&& subscription, QueuePtr queue);
 
@@ -59,6 +63,17 @@ public:
 
 	bool hasMessage();
 	T getMessage();
+	std::experimental::optional<T> tryGetMessage();
+	template<typename Rep, typename Period> std::experimental::optional<T> getMessageFor(
+			const std::chrono::duration<Rep, Period>& timeout);
+	template<typename Clock, typename Duration> std::experimental::optional<T> getMessageUntil(
+			const std::chrono::time_point<Clock, Duration>& deadline);
+
+	template<typename OutputIt> std::size_t drain(OutputIt out,
+			std::size_t max = std::numeric_limits<std::size_t>::max());
+	template<typename OutputIt, typename Rep, typename Period> std::size_t drainFor(
+			OutputIt out, const std::chrono::duration<Rep, Period>& timeout,
+			std::size_t max = std::numeric_limits<std::size_t>::max());
 
 	void setOnNewElement(std::function<void(void)> callback);
 	void unsetOnNewElement();
@@ -92,7 +107,7 @@ inline BufferedSubscription<T>& BufferedSubscription<T>::operator =(
  * Constructs a BufferedSubscription<T>.
  *
  * @param subscription the existing Subscription to turn into a BufferedSubscription<T>
- * @param queue the ThreadSafeQueue<T> to wrap
+ * @param queue the queue to wrap
  */
 template<typename T>
 inline BufferedSubscription<T>::BufferedSubscription(
@@ -134,6 +149,105 @@ inline T BufferedSubscription<T>::getMessage() {
 	return queue->dequeue();
 }
 
+/**
+ * Retrieve a message if there is one, without blocking.
+ *
+ * @return the message wrapped in an optional, or an empty optional if there
+ *         is no message
+ */
+template<typename T>
+inline std::experimental::optional<T> BufferedSubscription<T>::tryGetMessage() {
+	if (!queue) {
+		throw std::logic_error(
+				"Invalid BuferedSubscription - did you move it?");
+	}
+	return queue->tryDequeue();
+}
+
+/**
+ * Retrieve a message, waiting at most for a timeout.
+ *
+ * @param timeout the maximum time to wait for a message
+ * @return the message wrapped in an optional, or an empty optional on timeout
+ */
+template<typename T>
+template<typename Rep, typename Period>
+inline std::experimental::optional<T> BufferedSubscription<T>::getMessageFor(
+		const std::chrono::duration<Rep, Period>& timeout) {
+	return getMessageUntil(std::chrono::steady_clock::now() + timeout);
+}
+
+/**
+ * Retrieve a message, waiting at most until a deadline.
+ *
+ * @param deadline point in time to give up waiting
+ * @return the message wrapped in an optional, or an empty optional on timeout
+ */
+template<typename T>
+template<typename Clock, typename Duration>
+inline std::experimental::optional<T> BufferedSubscription<T>::getMessageUntil(
+		const std::chrono::time_point<Clock, Duration>& deadline) {
+	if (!queue) {
+		throw std::logic_error(
+				"Invalid BuferedSubscription - did you move it?");
+	}
+	// the queues wait on the steady clock - translate other clocks
+	auto steadyDeadline = std::chrono::steady_clock::now()
+			+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					deadline - Clock::now());
+	return queue->dequeueUntil(steadyDeadline);
+}
+
+/**
+ * Retrieve all buffered messages at once.
+ * Takes the buffer's lock (or updates its read position) only once, instead of
+ * once per message.
+ *
+ * @param out output iterator the messages are moved to
+ * @param max the maximum number of messages to retrieve
+ * @return the number of retrieved messages
+ */
+template<typename T>
+template<typename OutputIt>
+inline std::size_t BufferedSubscription<T>::drain(OutputIt out,
+		std::size_t max) {
+	if (!queue) {
+		throw std::logic_error(
+				"Invalid BuferedSubscription - did you move it?");
+	}
+	return queue->drain([&out](T&& message) {
+		*out = std::move(message);
+		++out;
+	}, max);
+}
+
+/**
+ * Retrieve all buffered messages at once, waiting for the first one.
+ * Like drain, but blocks until there is at least one message or the timeout
+ * has expired.
+ *
+ * @param out output iterator the messages are moved to
+ * @param timeout the maximum time to wait for a message
+ * @param max the maximum number of messages to retrieve
+ * @return the number of retrieved messages - 0 on timeout
+ */
+template<typename T>
+template<typename OutputIt, typename Rep, typename Period>
+inline std::size_t BufferedSubscription<T>::drainFor(OutputIt out,
+		const std::chrono::duration<Rep, Period>& timeout, std::size_t max) {
+	if (!queue) {
+		throw std::logic_error(
+				"Invalid BuferedSubscription - did you move it?");
+	}
+	auto deadline = std::chrono::steady_clock::now()
+			+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					timeout);
+	return queue->drainUntil([&out](T&& message) {
+		*out = std::move(message);
+		++out;
+	}, deadline, max);
+}
+
 /**
  * Changes the event callback for availability of new elements.
  *
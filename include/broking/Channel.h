@@ -23,14 +23,31 @@
 
 #include "broking/AbstractChannelBase.h"
 #include "broking/BufferedSubscription.h"
+#include "broking/ChannelStats.h"
+#include "broking/Executor.h"
+#include "broking/LatencyHistogram.h"
+#include "broking/MPMCQueue.h"
+#include "broking/OverflowPolicy.h"
+#include "broking/RcuPointer.h"
+#include "broking/SPSCQueue.h"
+#include "broking/SeqLockCell.h"
 #include "broking/ThreadSafeQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <mutex>
-#include <thread>
-#include <tuple>
 #include <condition_variable>
+#include <deque>
+#include <exception>
 #include <map>
+#include <memory>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace broking {
 
@@ -40,10 +57,25 @@ namespace broking {
 constexpr int DEFAULT_BUFFERSIZE = 5;
 
 /**
- * size of queue used for publishing.
+ * requested size of queue used for publishing.
+ * @attention MPMCQueue rounds it up to a power of two, so the publishing queue
+ *            (and the priority lane) really hold 8 Publications - this is
+ *            also the capacity getStats() reports
  */
 constexpr int PUBLISHING_QUEUE_SIZE = 5;
 
+/**
+ * maximum number of messages a channel dispatches before handing its worker
+ * to the next channel.
+ */
+constexpr int PROCESSING_BATCH_SIZE = 32;
+
+/**
+ * default number of Severity::ERROR publications dispatched for every
+ * Severity::WARNING publication with LaneScheduling::WEIGHTED
+ */
+constexpr unsigned DEFAULT_PRIORITY_WEIGHT = 4;
+
 /**
  * Describes the severity of a message drop
  */
@@ -52,6 +84,37 @@ enum class Severity {
 };
 std::ostream& operator<<(std::ostream& os, const Severity& s);
 
+/**
+ * Selects how a channel orders messages of different Severity
+ */
+enum class LaneScheduling {
+    FIFO, ///< a single queue - all messages in publishing order
+    STRICT, ///< Severity::ERROR first, as long as there are any
+    WEIGHTED ///< Severity::ERROR first, but let Severity::WARNING through regularly
+};
+
+/**
+ * What became of a message that was passed to a subscriber
+ */
+enum class Delivery {
+    DELIVERED, ///< the subscriber got the message
+    DROPPED_BY_POLICY, ///< dropped or replaced by the subscriber's OverflowPolicy, as intended
+    FAILED ///< dropped against the policy's intention - handled according to the Severity
+};
+
+/**
+ * Selects the queue that buffers a BufferedSubscription
+ */
+enum class BufferType {
+    LOCKING, ///< ThreadSafeQueue - any number of consumer threads
+    SPSC ///< lock-free SPSCQueue - only one consumer thread at a time
+};
+
+/**
+ * Executor shared by all channels - defined in Broker.cpp
+ */
+Executor& getSharedExecutor();
+
 /**
  * Generic asynchronous channel for message passing.
  *
@@ -59,17 +122,119 @@ std::ostream& operator<<(std::ostream& os, const Severity& s);
  * @version 1.0
  */
 template<typename T> class Channel: public AbstractChannelBase {
+public:
+    /// decides on the dispatching side which messages a subscriber gets
+    using Filter = std::function<bool(const T&)>;
+
 private:
-    bool run; ///< flag for the processing loop
-    std::thread processingThread; ///< handle for the processing thread
+    /**
+     * A callback or buffer, together with its Filter.
+     */
+    struct Subscriber {
+        std::function<Delivery(T&&)> sink; ///< passes a message on
+        Filter filter; ///< empty to pass on all messages
+        std::shared_ptr<SubscriberCounters> counters; ///< statistics - shared by all snapshots
+
+        /**
+         * @param message the message
+         * @return true if the message is passed on
+         */
+        bool accepts(const T& message) const {
+            return !filter || filter(message);
+        }
+    };
+
+    /// immutable snapshot of the subscribers, as read by the processing task
+    using SubscriberList = std::vector<std::pair<int, Subscriber>>;
+
+    /**
+     * Entry of the publishing queue - a single message or a batch of messages.
+     */
+    struct Publication {
+        std::experimental::optional<T> message; ///< a single message
+        std::vector<T> batch; ///< messages published as one batch
+        Severity severity; ///< the Severity if a message is dropped
+        LatencyHistogram::Stamp published; ///< when it was published, if latency is tracked
+
+        /**
+         * Constructs a Publication of a single message in place.
+         *
+         * @param severity the Severity if the message is dropped
+         * @param published when the message was published
+         * @param args the arguments to construct the message from
+         */
+        template<typename ... Args>
+        Publication(Severity severity, LatencyHistogram::Stamp published,
+                std::experimental::in_place_t, Args&&... args) :
+                message(std::experimental::in_place,
+                        std::forward<Args>(args)...), severity(severity), published(
+                        published) {
+        }
+
+        /**
+         * Constructs a Publication of a batch.
+         *
+         * @param severity the Severity if a message is dropped
+         * @param published when the batch was published
+         * @param batch the messages
+         */
+        Publication(Severity severity, LatencyHistogram::Stamp published,
+                std::vector<T>&& batch) :
+                batch(std::move(batch)), severity(severity), published(
+                        published) {
+        }
+    };
+
+    /**
+     * A message that is dispatched to several partitions of the subscribers
+     * in parallel. Partitions are claimed by the processing task and by
+     * helper tasks on the executor, whoever comes first.
+     */
+    struct FanOut {
+        Channel* channel; ///< the channel that dispatches
+        std::vector<T> messages; ///< one copy of the message per partition
+        Severity severity; ///< the Severity if the message is dropped
+        const SubscriberList* receivers; ///< snapshot of the subscribers - kept alive by the processing task
+        std::size_t partitions; ///< number of partitions
+        std::atomic<std::size_t> next; ///< next partition to claim
+        std::mutex mtxDone; ///< protects done and error
+        std::condition_variable cvDone; ///< signalled when a partition is finished
+        std::size_t done; ///< number of finished partitions
+        std::exception_ptr error; ///< the first exception thrown by a partition
+    };
+
+    Executor& executor; ///< runs the processing of published messages
+    std::atomic<bool> scheduled; ///< true while processing is queued or running
+    int pendingTasks; ///< number of processing tasks handed to the executor
+    int processingWaiters; ///< number of threads waiting on cvProcessingWait
     std::mutex mtxProcessingWait; ///< mutex to coordinate blocking
-    std::mutex mtxSubscribers; ///< mutex to coordinate access to the subscribers
-    std::condition_variable cvProcessingWait; ///< condition variable to wait on
-    ThreadSafeQueue<std::tuple<T, Severity>> publishingQueue; ///< buffers published messages
-    std::map<int, std::function<bool(T)>> subscribers; ///< stores the subscribers
+    std::mutex mtxSubscribers; ///< mutex to coordinate changes to the subscribers
+    std::condition_variable cvProcessingWait; ///< signalled when a processing task finishes
+    MPMCQueue<Publication> publishingQueue; ///< buffers published messages
+    MPMCQueue<Publication> priorityQueue; ///< buffers Severity::ERROR messages if priority lanes are used
+    std::atomic<LaneScheduling> laneScheduling; ///< how the queues are drained
+    std::atomic<unsigned> priorityWeight; ///< ERROR publications per WARNING publication for LaneScheduling::WEIGHTED
+    unsigned priorityStreak; ///< ERROR publications since the last WARNING one - only used by the processing task
+    std::map<int, Subscriber> subscribers; ///< stores the subscribers
+    std::map<int, std::shared_ptr<AbstractQueueBase<T>>> buffers; ///< buffers of the BufferedSubscriptions, for statistics
+    SubscriberList pendingReplays; ///< new subscribers that still get the history - protected by mtxSubscribers
+    std::atomic<bool> replayPending; ///< true if pendingReplays isn't empty
+    std::atomic<std::size_t> historySize; ///< number of messages kept for replay - 0 to disable
+    std::deque<T> history; ///< the latest dispatched messages - only used by the processing task
+    std::atomic<bool> inlineDispatch; ///< true if publishing threads dispatch themselves
+    std::mutex mtxInline; ///< held by the thread that dispatches inline
+    std::atomic<std::thread::id> inlineDispatcher; ///< the thread that dispatches inline, if any
+    std::deque<Publication> inlineQueue; ///< publications to dispatch inline - protected by mtxInline
+    std::atomic<std::size_t> fanOutPartitions; ///< number of partitions to dispatch in parallel - 0 or 1 to disable
+    RcuPointer<SubscriberList> subscriberSnapshot; ///< copy of subscribers, read without locks
+    LatencyHistogram queueWaitHistogram; ///< time messages spend in the publishing queue
+    LatencyHistogram dispatchHistogram; ///< time spent in each subscriber
+    std::shared_ptr<LatencyHistogram> dwellHistogram; ///< time messages spend in subscription buffers
+    ChannelCounters counters; ///< statistics
+    std::atomic<SeqLockCell<T>*> latest; ///< the latest published message, if enabled
     std::string name; ///< stores the name of the channel
 public:
-    Channel(std::string name);
+    Channel(std::string name, Executor& executor = getSharedExecutor());
 
     // Prevent moving and copying
     /**
@@ -94,14 +259,90 @@ public:
 
     virtual ~Channel();
 
-    void processingLoop();
-
-    void publish(T message, Severity severity = Severity::ERROR);
+    void publish(const T& message, Severity severity = Severity::ERROR);
+    void publish(T&& message, Severity severity = Severity::ERROR);
+    template<typename ... Args> void emplace(Args&&... args);
+    bool tryPublish(const T& message, Severity severity = Severity::ERROR);
+    bool tryPublish(T&& message, Severity severity = Severity::ERROR);
+    template<typename InputIt> void publish(InputIt first, InputIt last,
+            Severity severity = Severity::ERROR);
+    void publish(std::vector<T>&& messages, Severity severity = Severity::ERROR);
     Subscription subscribe(std::function<void(T)> callback, bool persistent = false);
-    BufferedSubscription<T> subscribe(int buffersize = DEFAULT_BUFFERSIZE);
+    template<typename Predicate> Subscription subscribe(Predicate filter,
+            std::function<void(T)> callback, bool persistent = false);
+    BufferedSubscription<T> subscribe(int buffersize = DEFAULT_BUFFERSIZE,
+            BufferType type = BufferType::LOCKING, OverflowPolicy<T> policy =
+                    OverflowPolicy<T>(), WaitStrategy wait = WaitStrategy());
+    BufferedSubscription<T> subscribe(Filter filter, int buffersize,
+            BufferType type = BufferType::LOCKING, OverflowPolicy<T> policy =
+                    OverflowPolicy<T>(), WaitStrategy wait = WaitStrategy());
     void unsubscribe(const Subscription& subscription) override;
     std::string getName();
 
+    void setHistorySize(std::size_t size);
+    void setLaneScheduling(LaneScheduling scheduling, unsigned weight =
+            DEFAULT_PRIORITY_WEIGHT);
+    void setInlineDispatch(bool enable);
+    void setWaitStrategy(WaitStrategy strategy);
+    void setParallelFanOut(std::size_t partitions);
+
+    void enableLatest();
+    std::experimental::optional<T> getLatest();
+
+    void setLatencyTracking(bool enable) override;
+    ChannelLatency getLatency() override;
+    ChannelStats getStats() override;
+
+private:
+    template<typename ... Args> void publish_(std::uint64_t messages,
+            Severity severity, Args&&... args);
+    template<typename ... Args> bool publishInline_(bool wait,
+            const T* latest, std::uint64_t messages, Severity severity,
+            Args&&... args);
+    MPMCQueue<Publication>& laneFor_(Severity severity);
+    std::experimental::optional<Publication> dequeueNext_();
+    template<typename U = T> typename std::enable_if<
+            std::is_trivially_copyable<U>::value>::type storeLatest_(
+            const U& message);
+    template<typename U = T> typename std::enable_if<
+            !std::is_trivially_copyable<U>::value>::type storeLatest_(
+            const U& message);
+    void schedule();
+    void processMessages();
+    void deliver_(Publication& publication, const SubscriberList& receivers);
+    void dispatch(T& message, Severity severity,
+            const SubscriberList& receivers);
+    void dispatchRange_(T& message, Severity severity,
+            const SubscriberList& receivers, std::size_t first,
+            std::size_t last);
+    void dispatchParallel_(T& message, Severity severity,
+            const SubscriberList& receivers, std::size_t partitions);
+    static void runPartitions_(FanOut& fanOut);
+    void count_(const std::pair<int, Subscriber>& subscriber,
+            Delivery delivery, Severity severity);
+    void dropped_(int subscriber, Severity severity);
+    void recordHistory_(const T& message);
+    void replayHistory_(const SubscriberList& receivers);
+    void addPendingReplay_(int subscriber, const Subscriber& sink);
+    Subscription subscribeCallback_(std::function<void(T)> callback,
+            Filter filter, bool persistent);
+    void checkCanSubscribe_();
+    void publishSubscribers_();
+    template<typename U = T> static typename std::enable_if<
+            std::is_copy_constructible<U>::value, U>::type copyMessage(
+            const U& message);
+    template<typename U = T> static typename std::enable_if<
+            !std::is_copy_constructible<U>::value, U>::type copyMessage(
+            const U& message);
+    template<typename Q> BufferedSubscription<T> subscribeBuffer(
+            std::shared_ptr<Q> buffer, const OverflowPolicy<T>& policy,
+            WaitStrategy wait, Filter filter);
+    std::function<Delivery(T&&)> bufferSink_(
+            std::shared_ptr<AbstractQueueBase<T>> buffer,
+            const OverflowPolicy<T>& policy);
+    std::function<Delivery(T&&)> bufferSink_(
+            std::shared_ptr<ThreadSafeQueue<T>> buffer,
+            const OverflowPolicy<T>& policy);
 };
 
 /**
@@ -113,79 +354,587 @@ extern Channel<std::string> WARNING_CHANNEL;
  * Constructs a Channel<T>.
  *
  * @param name the name of the channel.
+ * @param executor the Executor that processes published messages
  */
 template<typename T>
-inline Channel<T>::Channel(std::string name) :
-        run(true), publishingQueue(PUBLISHING_QUEUE_SIZE), name(name) {
+inline Channel<T>::Channel(std::string name, Executor& executor) :
+        executor(executor), scheduled(false), pendingTasks(0), processingWaiters(0), publishingQueue(
+                PUBLISHING_QUEUE_SIZE), priorityQueue(PUBLISHING_QUEUE_SIZE), laneScheduling(
+                LaneScheduling::FIFO), priorityWeight(DEFAULT_PRIORITY_WEIGHT), priorityStreak(
+                0), replayPending(false), historySize(0), inlineDispatch(false), inlineDispatcher(
+                std::thread::id()), fanOutPartitions(0), subscriberSnapshot(
+                std::unique_ptr<SubscriberList>(new SubscriberList())), dwellHistogram(
+                std::make_shared<LatencyHistogram>()), latest(nullptr), name(
+                name) {
     LOG_TRACE<< "Constructing Channel with T=" << typeid(T).name() << std::endl;
-    processingThread = std::thread(&Channel::processingLoop, this);
 }
 
 /**
  * Destructs a Channel.
+ * Waits for all processing tasks handed to the executor.
  */
 template<typename T>
 inline Channel<T>::~Channel() {
     LOG_TRACE<< "Destructing Channel with T=" << typeid(T).name() << std::endl;
 
-    // stop processing thread and join it for clean exit
-    run = false;
-    cvProcessingWait.notify_all();// will quite likely be sleeping
-    processingThread.join();
+    {
+        std::unique_lock<std::mutex> lock(mtxProcessingWait);
+        ++processingWaiters;
+        while (pendingTasks > 0) {
+            cvProcessingWait.wait(lock);
+        }
+        --processingWaiters;
+    }
+    delete latest.load();
+}
+
+/**
+ * Puts a Publication into the queue of its lane, counts it and schedules the
+ * processing - or dispatches it right away, if inline dispatch is enabled.
+ * Waits for space if the queue is full - the time spent waiting is counted as
+ * well.
+ *
+ * @param messages number of messages in the Publication
+ * @param severity the Severity if a message is dropped - selects the lane
+ * @param args the remaining arguments to construct the Publication from
+ */
+template<typename T>
+template<typename ... Args>
+inline void Channel<T>::publish_(std::uint64_t messages, Severity severity,
+        Args&&... args) {
+    if (inlineDispatch.load(std::memory_order_relaxed)) {
+        publishInline_(true, nullptr, messages, severity,
+                std::forward<Args>(args)...);
+        return;
+    }
+
+    MPMCQueue<Publication>& lane = laneFor_(severity);
+
+    // tryEmplace leaves the arguments untouched if the queue is full
+    if (!lane.tryEmplace(severity, std::forward<Args>(args)...)) {
+        auto start = std::chrono::steady_clock::now();
+        // a callback that waits here holds its worker - the pool may have to
+        // replace it, so the processing of this channel isn't starved
+        Executor::Blocking blocking;
+        lane.emplace(severity, std::forward<Args>(args)...);
+        counters.countBlocked(std::chrono::steady_clock::now() - start);
+    }
+    counters.countPublished(messages);
+
+    // now there is something to process
+    schedule();
+}
+
+/**
+ * Dispatches a Publication on the calling thread.
+ * Only one thread dispatches at a time, so the order is the same as with the
+ * processing task. A Publication from a subscriber of this channel (on the
+ * dispatching thread) is queued and dispatched after the current one, instead
+ * of nesting.
+ *
+ * @param wait false to give up if another thread is dispatching
+ * @param latest stored as the latest message once the Publication is
+ *               accepted, before it is dispatched - nullptr if the caller
+ *               already stored it
+ * @param messages number of messages in the Publication
+ * @param severity the Severity if a message is dropped
+ * @param args the remaining arguments to construct the Publication from - left
+ *             untouched if it gives up
+ * @retval true the Publication was dispatched or queued
+ * @retval false another thread is dispatching and wait was false
+ *
+ * @throws std::runtime_error if a message with Severity::ERROR is dropped
+ */
+template<typename T>
+template<typename ... Args>
+inline bool Channel<T>::publishInline_(bool wait, const T* latest,
+        std::uint64_t messages, Severity severity, Args&&... args) {
+    if (inlineDispatcher.load() == std::this_thread::get_id()) {
+        // published by a subscriber - the dispatching loop below picks it up
+        if (latest) {
+            storeLatest_(*latest);
+        }
+        inlineQueue.emplace_back(severity, std::forward<Args>(args)...);
+        counters.countPublished(messages);
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mtxInline, std::defer_lock);
+    if (wait) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return false;
+    }
+
+    // before args may move from it
+    if (latest) {
+        storeLatest_(*latest);
+    }
+    inlineQueue.emplace_back(severity, std::forward<Args>(args)...);
+    counters.countPublished(messages);
+
+    inlineDispatcher = std::this_thread::get_id();
+    try {
+        while (!inlineQueue.empty()) {
+            // subscribers may change while dispatching without blocking us
+            typename RcuPointer<SubscriberList>::ReadGuard receivers(
+                    subscriberSnapshot);
+            if (replayPending.load()) {
+                replayHistory_(*receivers);
+            }
+
+            // appending doesn't invalidate the reference
+            deliver_(inlineQueue.front(), *receivers);
+            inlineQueue.pop_front();
+        }
+    } catch (...) {
+        inlineQueue.clear();
+        inlineDispatcher = std::thread::id();
+        throw;
+    }
+    inlineDispatcher = std::thread::id();
+    return true;
 }
 
 /**
- * Processing loop - run in a separate thread.
+ * @param severity the Severity of a publication
+ * @return the queue the publication goes to
  */
 template<typename T>
-inline void Channel<T>::processingLoop() {
+inline MPMCQueue<typename Channel<T>::Publication>& Channel<T>::laneFor_(
+        Severity severity) {
+    if (severity == Severity::ERROR
+            && laneScheduling.load(std::memory_order_relaxed)
+                    != LaneScheduling::FIFO) {
+        return priorityQueue;
+    }
+    return publishingQueue;
+}
+
+/**
+ * Takes the next publication to dispatch from the queues, according to the
+ * LaneScheduling.
+ * @attention only called by the processing task
+ *
+ * @return the publication, or an empty optional if both queues are empty
+ */
+template<typename T>
+inline std::experimental::optional<typename Channel<T>::Publication> Channel<T>::dequeueNext_() {
+    LaneScheduling scheduling = laneScheduling.load(std::memory_order_relaxed);
+    bool preferPriority = scheduling == LaneScheduling::STRICT
+            || (scheduling == LaneScheduling::WEIGHTED
+                    && priorityStreak
+                            < priorityWeight.load(std::memory_order_relaxed));
+
+    if (preferPriority) {
+        auto publication = priorityQueue.tryDequeue();
+        if (publication) {
+            ++priorityStreak;
+            return publication;
+        }
+    }
+
+    auto publication = publishingQueue.tryDequeue();
+    if (publication) {
+        priorityStreak = 0;
+        return publication;
+    }
+
+    // the WARNING lane is empty - or scheduling was changed to FIFO while
+    // there still were priority messages
+    publication = priorityQueue.tryDequeue();
+    if (publication) {
+        ++priorityStreak;
+    }
+    return publication;
+}
+
+/**
+ * Hands a processing task to the executor, unless one is already queued or
+ * running. There is never more than one processing task per channel, which
+ * keeps the messages in FIFO order.
+ */
+template<typename T>
+inline void Channel<T>::schedule() {
+    if (scheduled.exchange(true)) {
+        // the running task will pick up the message
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtxProcessingWait);
+        ++pendingTasks;
+    }
+    executor.execute([this]() {processMessages();});
+}
+
+/**
+ * Processing task - run by the executor.
+ * Dispatches up to PROCESSING_BATCH_SIZE messages and reschedules itself if
+ * there are more.
+ */
+template<typename T>
+inline void Channel<T>::processMessages() {
     LOG_SCOPE
+    LOG_TRACE<< "Processing..." << std::endl;
+
+    for (int i = 0; i < PROCESSING_BATCH_SIZE; ++i) {
+        // subscribers may change while dispatching without blocking us
+        typename RcuPointer<SubscriberList>::ReadGuard receivers(
+                subscriberSnapshot);
+
+        // a new subscriber in the snapshot was added to pendingReplays
+        // before, so it gets the history before its first live message
+        if (replayPending.load()) {
+            replayHistory_(*receivers);
+        }
+
+        // the queue only grows between dequeues, so this catches every peak
+        counters.updatePeakQueueDepth(
+                publishingQueue.size() + priorityQueue.size());
+        auto publication = dequeueNext_();
+        if (!publication) {
+            // no more messages
+            break;
+        }
+        queueWaitHistogram.recordSince(publication->published);
+        deliver_(*publication, *receivers);
+    }
+
+    // release the channel - a message published or a subscriber added after
+    // this point schedules a new task, those before are caught by the check
+    // below.
+    scheduled = false;
+    if (publishingQueue.canDequeue() || priorityQueue.canDequeue()
+            || replayPending.load()) {
+        schedule();
+    }
+
+    // must be the last access to this, the destructor might be waiting
+    std::lock_guard<std::mutex> lock(mtxProcessingWait);
+    --pendingTasks;
+    if (pendingTasks == 0 && processingWaiters > 0) {
+        cvProcessingWait.notify_all();
+    }
+}
+
+/**
+ * Passes all messages of a Publication to all subscribers.
+ *
+ * @param publication the Publication - its messages are moved from
+ * @param receivers snapshot of the subscribers
+ */
+template<typename T>
+inline void Channel<T>::deliver_(Publication& publication,
+        const SubscriberList& receivers) {
+    if (publication.message) {
+        recordHistory_(*publication.message);
+        dispatch(*publication.message, publication.severity, receivers);
+    } else {
+        // deliver the batch as one contiguous run
+        for (auto&& message : publication.batch) {
+            recordHistory_(message);
+            dispatch(message, publication.severity, receivers);
+        }
+    }
+}
+
+/**
+ * Passes a message to all subscribers - in parallel partitions, if enabled.
+ * Returns once all subscribers got the message.
+ *
+ * @param message the message - moved from
+ * @param severity the Severity if the message is dropped
+ * @param receivers snapshot of the subscribers
+ */
+template<typename T>
+inline void Channel<T>::dispatch(T& message, Severity severity,
+        const SubscriberList& receivers) {
+    std::size_t partitions = std::min(
+            fanOutPartitions.load(std::memory_order_relaxed), receivers.size());
+    if (partitions > 1 && !inlineDispatch.load(std::memory_order_relaxed)) {
+        dispatchParallel_(message, severity, receivers, partitions);
+    } else {
+        dispatchRange_(message, severity, receivers, 0, receivers.size());
+    }
+}
+
+/**
+ * Passes a message to a range of subscribers, one after another.
+ * Subscribers whose Filter rejects the message are skipped without copying
+ * it. Every other subscriber but the last gets a copy, the last one gets the
+ * message moved in.
+ *
+ * @param message the message - moved from
+ * @param severity the Severity if the message is dropped
+ * @param receivers snapshot of the subscribers
+ * @param first index of the first subscriber
+ * @param last index behind the last subscriber
+ */
+template<typename T>
+inline void Channel<T>::dispatchRange_(T& message, Severity severity,
+        const SubscriberList& receivers, std::size_t first, std::size_t last) {
+    // the last subscriber that takes the message gets it moved in
+    while (last > first && !receivers[last - 1].second.accepts(message)) {
+        --last;
+    }
+
+    for (std::size_t i = first; i < last; ++i) {
+        auto&& subscriber = receivers[i];
+        // the filter of the last one was already called above
+        if (i + 1 != last && !subscriber.second.accepts(message)) {
+            continue;
+        }
+
+        // subscriber.second.sink is the lambda
+        // call lambda with the message
+        auto start = dispatchHistogram.stamp();
+        Delivery delivery = i + 1 == last ?
+                subscriber.second.sink(std::move(message)) :
+                subscriber.second.sink(copyMessage(message));
+        dispatchHistogram.recordSince(start);
+
+        count_(subscriber, delivery, severity);
+    }
+}
+
+/**
+ * Passes a message to partitions of the subscribers in parallel.
+ * Hands a helper task per additional partition to the executor and works on
+ * the partitions itself as well, so it never waits for a partition that
+ * hasn't been started. Returns once all partitions are finished - so each
+ * subscriber still gets the messages in order.
+ *
+ * @param message the message - moved from
+ * @param severity the Severity if the message is dropped
+ * @param receivers snapshot of the subscribers - must stay alive until this
+ *                  returns
+ * @param partitions number of partitions
+ *
+ * @throws std::runtime_error if a message with Severity::ERROR is dropped
+ */
+template<typename T>
+inline void Channel<T>::dispatchParallel_(T& message, Severity severity,
+        const SubscriberList& receivers, std::size_t partitions) {
+    auto fanOut = std::make_shared<FanOut>();
+    fanOut->channel = this;
+    fanOut->messages.reserve(partitions);
+    for (std::size_t i = 1; i < partitions; ++i) {
+        fanOut->messages.push_back(copyMessage(message));
+    }
+    fanOut->messages.push_back(std::move(message));
+    fanOut->severity = severity;
+    fanOut->receivers = &receivers;
+    fanOut->partitions = partitions;
+    fanOut->next = 0;
+    fanOut->done = 0;
+
+    for (std::size_t i = 1; i < partitions; ++i) {
+        // the helper keeps fanOut alive, even if it starts after we are done
+        executor.execute([fanOut]() {runPartitions_(*fanOut);});
+    }
+    runPartitions_(*fanOut);
+
+    std::unique_lock<std::mutex> lock(fanOut->mtxDone);
+    while (fanOut->done < partitions) {
+        fanOut->cvDone.wait(lock);
+    }
+    if (fanOut->error) {
+        std::rethrow_exception(fanOut->error);
+    }
+}
+
+/**
+ * Dispatches partitions of a FanOut until all are claimed.
+ * Doesn't touch the channel if all partitions were claimed already - it may
+ * be gone by then.
+ *
+ * @param fanOut the message to dispatch
+ */
+template<typename T>
+inline void Channel<T>::runPartitions_(FanOut& fanOut) {
+    while (true) {
+        std::size_t partition = fanOut.next.fetch_add(1);
+        if (partition >= fanOut.partitions) {
+            return;
+        }
+
+        std::exception_ptr error;
+        {
+            // so subscribers can unsubscribe themselves, like on the
+            // processing task
+            typename RcuPointer<SubscriberList>::ReadSectionMark mark(
+                    fanOut.channel->subscriberSnapshot);
+            std::size_t size = fanOut.receivers->size();
+            try {
+                fanOut.channel->dispatchRange_(fanOut.messages[partition],
+                        fanOut.severity, *fanOut.receivers,
+                        size * partition / fanOut.partitions,
+                        size * (partition + 1) / fanOut.partitions);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
 
-    // create a unique_lock, but don't lock the mutex yet.
-    std::unique_lock<std::mutex> lock(mtxProcessingWait, std::defer_lock);
-
-    while (run) {
-        LOG_TRACE<< "Processing..." << std::endl;
-
-        while(publishingQueue.canDequeue()) {
-            // there is a message
-
-            // "unpack" tuple
-            Severity severity;
-            T message;
-            std::tie(message, severity) = publishingQueue.dequeue();
-
-            std::lock_guard<std::mutex>lock(mtxSubscribers);
-            for(auto&& subscriber : subscribers) {
-                // subscriber.second is the lambda
-                // call lambda with the message
-                bool successfull = subscriber.second(message);
-
-                // if lambda returned false, the message was dropped
-                if(!successfull) {
-                    if(severity == Severity::ERROR) {
-                        LOG_ERROR << "Dropped critical Message on Channel \""
-                        << name << "\" - Subscriber "
-                        << subscriber.first << " didn't accept!"
-                        << std::endl;
-
-                        throw std::runtime_error(
-                                "Dropped critical message on Channel \""
-                                + name + "\"");
-                    } else {
-                        WARNING_CHANNEL.publish("Dropped a message on Channel \""
-                                + name + "\" - Subscriber "
-                                + std::to_string(subscriber.first)
-                                + " didn't accept...");
-                    }
+        std::lock_guard<std::mutex> lock(fanOut.mtxDone);
+        if (error && !fanOut.error) {
+            fanOut.error = error;
+        }
+        ++fanOut.done;
+        fanOut.cvDone.notify_one();
+    }
+}
+
+/**
+ * Counts a message that was passed to a subscriber - every message counts
+ * either as delivered or as dropped, for the channel and for the subscriber.
+ *
+ * @param subscriber ID and Subscriber the message was passed to
+ * @param delivery what became of the message
+ * @param severity the Severity of the message
+ *
+ * @throws std::runtime_error if the message failed and severity is
+ *                            Severity::ERROR
+ */
+template<typename T>
+inline void Channel<T>::count_(const std::pair<int, Subscriber>& subscriber,
+        Delivery delivery, Severity severity) {
+    switch (delivery) {
+    case Delivery::DELIVERED:
+        counters.countDelivered();
+        subscriber.second.counters->countDelivered();
+        break;
+    case Delivery::DROPPED_BY_POLICY:
+        counters.countDroppedByPolicy();
+        subscriber.second.counters->countDroppedByPolicy();
+        break;
+    case Delivery::FAILED:
+    default:
+        subscriber.second.counters->countDropped();
+        dropped_(subscriber.first, severity);
+        break;
+    }
+}
+
+/**
+ * Handles a message a subscriber didn't accept.
+ *
+ * @param subscriber ID of the subscriber
+ * @param severity the Severity of the message
+ *
+ * @throws std::runtime_error if severity is Severity::ERROR
+ */
+template<typename T>
+inline void Channel<T>::dropped_(int subscriber, Severity severity) {
+    if(severity == Severity::ERROR) {
+        counters.countDroppedError();
+        LOG_ERROR << "Dropped critical Message on Channel \""
+        << name << "\" - Subscriber "
+        << subscriber << " didn't accept!"
+        << std::endl;
+
+        throw std::runtime_error(
+                "Dropped critical message on Channel \""
+                + name + "\"");
+    } else {
+        counters.countDroppedWarning();
+        std::string warning = "Dropped a message on Channel \""
+                + name + "\" - Subscriber "
+                + std::to_string(subscriber)
+                + " didn't accept...";
+
+        // never block a worker on a full WARNING_CHANNEL
+        if (!WARNING_CHANNEL.tryPublish(warning)) {
+            LOG_WARNING << warning << std::endl;
+        }
+    }
+}
+
+/**
+ * Keeps a copy of a message for replay, if the history is enabled.
+ * @attention only called by the processing task
+ *
+ * @param message the message that is about to be dispatched
+ */
+template<typename T>
+inline void Channel<T>::recordHistory_(const T& message) {
+    std::size_t size = historySize.load(std::memory_order_relaxed);
+    if (size == 0 && history.empty()) {
+        return;
+    }
+
+    if (size > 0) {
+        history.push_back(copyMessage(message));
+    }
+    while (history.size() > size) {
+        history.pop_front();
+    }
+}
+
+/**
+ * Passes the history to the new subscribers that are part of the snapshot
+ * used for the next message. Newer subscribers stay pending - the next
+ * message isn't passed to them, so it has to be part of their replay.
+ * mtxSubscribers is only held to take over the pending subscribers, not while
+ * passing the messages.
+ * @attention only called by the processing task, inside a read section
+ *            of subscriberSnapshot - so unsubscribe waits for the replay
+ *
+ * @param receivers snapshot of the subscribers
+ */
+template<typename T>
+inline void Channel<T>::replayHistory_(const SubscriberList& receivers) {
+    SubscriberList replays;
+    {
+        std::lock_guard<std::mutex> lock(mtxSubscribers);
+        auto pending = pendingReplays.begin();
+        while (pending != pendingReplays.end()) {
+            bool inSnapshot = false;
+            for (auto&& receiver : receivers) {
+                if (receiver.first == pending->first) {
+                    inSnapshot = true;
+                    break;
                 }
             }
+
+            if (inSnapshot) {
+                replays.push_back(std::move(*pending));
+                pending = pendingReplays.erase(pending);
+            } else {
+                ++pending;
+            }
         }
-        // no more messages -> go to blocked and free CPU
-        lock.lock();
-        cvProcessingWait.wait(lock);
-        lock.unlock();
+        replayPending = !pendingReplays.empty();
     }
+
+    for (auto&& subscriber : replays) {
+        for (auto&& message : history) {
+            if (!subscriber.second.accepts(message)) {
+                continue;
+            }
+            // replayed messages are never critical
+            count_(subscriber, subscriber.second.sink(copyMessage(message)),
+                    Severity::WARNING);
+        }
+    }
+}
+
+/**
+ * Makes a new subscriber get the history before its first live message.
+ * @pre caller must hold mtxSubscribers!
+ *
+ * @param subscriber ID of the subscriber
+ * @param sink the subscriber
+ */
+template<typename T>
+inline void Channel<T>::addPendingReplay_(int subscriber,
+        const Subscriber& sink) {
+    if (historySize.load() == 0) {
+        return;
+    }
+
+    pendingReplays.emplace_back(subscriber, sink);
+    replayPending = true;
 }
 
 /**
@@ -196,35 +945,213 @@ inline void Channel<T>::processingLoop() {
  * @attention this WILL block if the publishing queue is full!
  */
 template<typename T>
-inline void Channel<T>::publish(T message, Severity severity) {
-    LOG_TRACE<< "Publishing " << message << std::endl;
-    publishingQueue.enqueue(std::make_tuple(message, severity));
+inline void Channel<T>::publish(const T& message, Severity severity) {
+    LOG_TRACE<< "Publishing on Channel \"" << name << "\"" << std::endl;
+    storeLatest_(message);
+    publish_(1, severity, queueWaitHistogram.stamp(),
+            std::experimental::in_place, message);
+}
+
+/**
+ * Publish a message on the Channel by moving it.
+ *
+ * @param message the message to publish
+ * @param severity the Severity if the message is dropped.
+ * @attention this WILL block if the publishing queue is full!
+ */
+template<typename T>
+inline void Channel<T>::publish(T&& message, Severity severity) {
+    LOG_TRACE<< "Publishing on Channel \"" << name << "\"" << std::endl;
+    storeLatest_(message);
+    publish_(1, severity, queueWaitHistogram.stamp(),
+            std::experimental::in_place, std::move(message));
+}
+
+/**
+ * Publish a message that is constructed in place with Severity::ERROR.
+ *
+ * @param args the arguments to construct the message from
+ * @attention this WILL block if the publishing queue is full!
+ */
+template<typename T>
+template<typename ... Args>
+inline void Channel<T>::emplace(Args&&... args) {
+    if (latest.load(std::memory_order_acquire)) {
+        // the cell needs the message before it is moved into the queue
+        publish(T(std::forward<Args>(args)...));
+        return;
+    }
 
-    // wakeup processing thread (in case it was sleeping)
-    // because now there is a message to process
-    cvProcessingWait.notify_all();
+    LOG_TRACE<< "Publishing on Channel \"" << name << "\"" << std::endl;
+    publish_(1, Severity::ERROR, queueWaitHistogram.stamp(),
+            std::experimental::in_place, std::forward<Args>(args)...);
+}
+
+/**
+ * Publish a batch of messages on the Channel.
+ * The batch takes a single slot in the publishing queue and is delivered to
+ * the subscribers as one contiguous run.
+ *
+ * @param first iterator to the first message
+ * @param last iterator behind the last message
+ * @param severity the Severity if a message is dropped.
+ * @attention this WILL block if the publishing queue is full!
+ */
+template<typename T>
+template<typename InputIt>
+inline void Channel<T>::publish(InputIt first, InputIt last,
+        Severity severity) {
+    publish(std::vector<T>(first, last), severity);
+}
+
+/**
+ * Publish a batch of messages on the Channel.
+ * The batch takes a single slot in the publishing queue and is delivered to
+ * the subscribers as one contiguous run.
+ *
+ * @param messages the messages to publish
+ * @param severity the Severity if a message is dropped.
+ * @attention this WILL block if the publishing queue is full!
+ */
+template<typename T>
+inline void Channel<T>::publish(std::vector<T>&& messages, Severity severity) {
+    if (messages.empty()) {
+        return;
+    }
+
+    LOG_TRACE<< "Publishing batch of " << messages.size() << " on Channel \""
+    << name << "\"" << std::endl;
+    storeLatest_(messages.back());
+    publish_(messages.size(), severity, queueWaitHistogram.stamp(),
+            std::move(messages));
+}
+
+/**
+ * Publish a message on the Channel, unless the publishing queue is full.
+ *
+ * @param message the message to publish
+ * @param severity the Severity if the message is dropped.
+ * @retval true the message was published
+ * @retval false the publishing queue is full
+ */
+template<typename T>
+inline bool Channel<T>::tryPublish(const T& message, Severity severity) {
+    LOG_TRACE<< "Publishing on Channel \"" << name << "\"" << std::endl;
+    if (inlineDispatch.load(std::memory_order_relaxed)) {
+        // stores the message as latest before subscribers get it
+        return publishInline_(false, &message, 1, severity,
+                LatencyHistogram::Stamp(), std::experimental::in_place,
+                message);
+    }
+    if (!laneFor_(severity).tryEmplace(severity, queueWaitHistogram.stamp(),
+            std::experimental::in_place, message)) {
+        return false;
+    }
+    counters.countPublished(1);
+    storeLatest_(message);
+
+    // now there is a message to process
+    schedule();
+    return true;
+}
+
+/**
+ * Publish a message on the Channel by moving it, unless the publishing queue
+ * is full.
+ *
+ * @param message the message to publish - left untouched if the queue is full
+ * @param severity the Severity if the message is dropped.
+ * @retval true the message was published
+ * @retval false the publishing queue is full
+ */
+template<typename T>
+inline bool Channel<T>::tryPublish(T&& message, Severity severity) {
+    LOG_TRACE<< "Publishing on Channel \"" << name << "\"" << std::endl;
+    if (inlineDispatch.load(std::memory_order_relaxed)) {
+        // stores the message as latest before it is moved and dispatched
+        return publishInline_(false, &message, 1, severity,
+                LatencyHistogram::Stamp(), std::experimental::in_place,
+                std::move(message));
+    }
+    if (!laneFor_(severity).tryEmplace(severity, queueWaitHistogram.stamp(),
+            std::experimental::in_place, std::move(message))) {
+        return false;
+    }
+    counters.countPublished(1);
+    // only trivially copyable messages are stored, moving them doesn't
+    // change them
+    storeLatest_(message);
+
+    // now there is a message to process
+    schedule();
+    return true;
 }
 
 /**
  * Subscribe a callback on the Channel.
- * @attention Callbacks are processed SYNCHRONOUSLY by the processing thread - keep it short!
+ * @attention Callbacks are processed SYNCHRONOUSLY by the executor - keep it short!
  *
  * @param callback the callback to subscribe
  * @return a Subscription to identify this later
  */
 template<typename T>
 inline Subscription Channel<T>::subscribe(std::function<void(T)> callback, bool persistent) {
+    return subscribeCallback_(std::move(callback), Filter(), persistent);
+}
+
+/**
+ * Subscribe a callback on the Channel that only gets the messages a filter
+ * accepts. The filter is called by the dispatching thread before the message
+ * is copied, so rejected messages only cost the call.
+ * The filter is a template parameter, so a lambda isn't ambiguous with
+ * subscribe(callback, persistent).
+ * @attention Callbacks and filters are processed SYNCHRONOUSLY by the executor - keep them short!
+ *
+ * @param filter returns true for the messages to pass to the callback
+ * @param callback the callback to subscribe
+ * @return a Subscription to identify this later
+ */
+template<typename T>
+template<typename Predicate>
+inline Subscription Channel<T>::subscribe(Predicate filter,
+        std::function<void(T)> callback, bool persistent) {
+    return subscribeCallback_(std::move(callback), Filter(std::move(filter)),
+            persistent);
+}
+
+/**
+ * Subscribes a callback with a filter.
+ *
+ * @param callback the callback to subscribe
+ * @param filter returns true for the messages to pass on - empty for all
+ * @param persistent true to stay subscribed when the Subscription is destroyed
+ * @return a Subscription to identify this later
+ */
+template<typename T>
+inline Subscription Channel<T>::subscribeCallback_(
+        std::function<void(T)> callback, Filter filter, bool persistent) {
     std::lock_guard<std::mutex> lock(mtxSubscribers);
 
+    checkCanSubscribe_();
+
     // create a new subscription
     Subscription s(*this, persistent);
 
-    // wrap callback in a lambda - will always return true, because the callback
-    // can't drop the message.
+    // wrap callback in a lambda - will always return Delivery::DELIVERED,
+    // because the callback can't drop the message.
     // the lambda is then stored in the subscriber map, with the subscription as
     // it's key
-    subscribers[s.getID()] = [callback](T message) {callback(message); return true;};
+    subscribers[s.getID()] = Subscriber { [callback](T&& message) {
+        callback(std::move(message));
+        return Delivery::DELIVERED;
+    }, std::move(filter), std::make_shared<SubscriberCounters>() };
+    addPendingReplay_(s.getID(), subscribers[s.getID()]);
+    publishSubscribers_();
 
+    if (replayPending.load() && !inlineDispatch.load()) {
+        // replay even if nothing is published
+        schedule();
+    }
     return s;
 }
 
@@ -232,38 +1159,260 @@ inline Subscription Channel<T>::subscribe(std::function<void(T)> callback, bool
  * Subscribe a buffer on the Channel.
  *
  * @param buffersize the size of the buffer
+ * @param type the kind of queue to use as buffer
+ * @param policy what to do with messages the buffer has no space for
+ * @param wait how the readers of the buffer wait for messages
+ * @return a BufferedSubscription to identify this later and to provide access to the buffer.
+ *
+ * @throws std::logic_error if a BufferType::SPSC buffer should drop the oldest
+ *                          message or conflate
+ */
+template<typename T>
+inline BufferedSubscription<T> Channel<T>::subscribe(int buffersize,
+        BufferType type, OverflowPolicy<T> policy, WaitStrategy wait) {
+    return subscribe(Filter(), buffersize, type, policy, wait);
+}
+
+/**
+ * Subscribe a buffer on the Channel that only gets the messages a filter
+ * accepts. The filter is called by the dispatching thread before the message
+ * is copied or enqueued, so rejected messages neither take space in the
+ * buffer nor wake its reader.
+ * @attention Filters are processed SYNCHRONOUSLY by the executor - keep them short!
+ *
+ * @param filter returns true for the messages to buffer - empty for all
+ * @param buffersize the size of the buffer
+ * @param type the kind of queue to use as buffer
+ * @param policy what to do with messages the buffer has no space for
+ * @param wait how the readers of the buffer wait for messages
  * @return a BufferedSubscription to identify this later and to provide access to the buffer.
+ *
+ * @throws std::logic_error if a BufferType::SPSC buffer should drop the oldest
+ *                          message or conflate
  */
 template<typename T>
-inline BufferedSubscription<T> Channel<T>::subscribe(int buffersize) {
+inline BufferedSubscription<T> Channel<T>::subscribe(Filter filter,
+        int buffersize, BufferType type, OverflowPolicy<T> policy,
+        WaitStrategy wait) {
     // create the buffer
-    auto buffer = std::make_shared<ThreadSafeQueue<T>>(buffersize);
+    switch (type) {
+    case BufferType::SPSC:
+        return subscribeBuffer(
+                std::make_shared<SPSCQueue<T>>(buffersize, dwellHistogram),
+                policy, wait, std::move(filter));
+    case BufferType::LOCKING:
+    default:
+        return subscribeBuffer(
+                std::make_shared<ThreadSafeQueue<T>>(buffersize,
+                        dwellHistogram), policy, wait, std::move(filter));
+    }
+}
+
+/**
+ * Subscribe an existing buffer on the Channel.
+ *
+ * @param buffer the queue to buffer the messages in
+ * @param policy what to do with messages the buffer has no space for
+ * @param wait how the readers of the buffer wait for messages
+ * @param filter returns true for the messages to buffer - empty for all
+ * @return a BufferedSubscription to identify this later and to provide access to the buffer.
+ */
+template<typename T>
+template<typename Q>
+inline BufferedSubscription<T> Channel<T>::subscribeBuffer(
+        std::shared_ptr<Q> buffer, const OverflowPolicy<T>& policy,
+        WaitStrategy wait, Filter filter) {
+    // fails for unsupported policies - before anything is registered
+    std::function<Delivery(T&&)> sink = bufferSink_(buffer, policy);
+    buffer->setWaitStrategy(wait);
 
     std::lock_guard<std::mutex> lock(mtxSubscribers);
 
+    checkCanSubscribe_();
+
     // create a subscription that is not persistent
     Subscription s(*this, false);
 
-    // create a lambda that captures the buffer and wraps it's tryEnqueue operation
-    // if tryEnqueue fails, it drops the message and returns false, which is
-    // exactly what the processing thread expects.
-    // the lambda is then stored in the subscriber map, with the subscription as
-    // it's key
-    subscribers[s.getID()] = [buffer](T message) {return buffer->tryEnqueue(message);};
+    // the sink is stored in the subscriber map, with the subscription as it's
+    // key
+    subscribers[s.getID()] = Subscriber { std::move(sink), std::move(filter),
+            std::make_shared<SubscriberCounters>() };
+    buffers[s.getID()] = buffer;
+    addPendingReplay_(s.getID(), subscribers[s.getID()]);
+    publishSubscribers_();
+
+    if (replayPending.load() && !inlineDispatch.load()) {
+        // replay even if nothing is published
+        schedule();
+    }
 
     // wrap Subscription and buffer in a BuferedSubscription
     return BufferedSubscription<T>(std::move(s), buffer);
 }
 
+/**
+ * Creates the subscriber for a buffer that applies an OverflowPolicy.
+ * The returned lambda only returns Delivery::FAILED if the message is dropped
+ * against the policy's intention, which the processing task then handles
+ * according to the message's Severity.
+ *
+ * @param buffer the queue to buffer the messages in
+ * @param policy what to do with messages the buffer has no space for
+ * @return the subscriber
+ *
+ * @throws std::logic_error if the buffer doesn't support the policy
+ */
+template<typename T>
+inline std::function<Delivery(T&&)> Channel<T>::bufferSink_(
+        std::shared_ptr<AbstractQueueBase<T>> buffer,
+        const OverflowPolicy<T>& policy) {
+    switch (policy.action) {
+    case OverflowAction::FAIL:
+        // if tryEnqueue fails, it drops the message
+        return [buffer](T&& message) {
+            return buffer->tryEnqueue(std::move(message)) ?
+                    Delivery::DELIVERED : Delivery::FAILED;
+        };
+    case OverflowAction::DROP_NEWEST:
+        return [buffer](T&& message) {
+            return buffer->tryEnqueue(std::move(message)) ?
+                    Delivery::DELIVERED : Delivery::DROPPED_BY_POLICY;
+        };
+    case OverflowAction::BLOCK: {
+        auto timeout = policy.timeout;
+        return [buffer, timeout](T&& message) {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            // waiting for space holds the worker - the pool may have to
+            // replace it, so other channels aren't stalled until the timeout
+            std::experimental::optional<Executor::Blocking> blocking;
+            if (!buffer->canEnqueue()) {
+                blocking.emplace();
+            }
+            return buffer->enqueueUntil(std::move(message), deadline) ?
+                    Delivery::DELIVERED : Delivery::FAILED;
+        };
+    }
+    default:
+        throw std::logic_error("Channel \"" + name
+                + "\" - this kind of buffer can't drop the oldest message or conflate");
+    }
+}
+
+/**
+ * Creates the subscriber for a ThreadSafeQueue that applies an OverflowPolicy.
+ * A ThreadSafeQueue supports all OverflowActions.
+ *
+ * @param buffer the queue to buffer the messages in
+ * @param policy what to do with messages the buffer has no space for
+ * @return the subscriber
+ */
+template<typename T>
+inline std::function<Delivery(T&&)> Channel<T>::bufferSink_(
+        std::shared_ptr<ThreadSafeQueue<T>> buffer,
+        const OverflowPolicy<T>& policy) {
+    switch (policy.action) {
+    // a buffered message that makes room for the new one was already
+    // counted as delivered - the new one counts as dropped instead, so every
+    // message is only counted once
+    case OverflowAction::DROP_OLDEST:
+        return [buffer](T&& message) {
+            return buffer->enqueueDroppingOldest(std::move(message)) ?
+                    Delivery::DROPPED_BY_POLICY : Delivery::DELIVERED;
+        };
+    case OverflowAction::CONFLATE: {
+        auto sameKey = policy.sameKey;
+        return [buffer, sameKey](T&& message) {
+            return buffer->enqueueConflating(std::move(message), sameKey) ?
+                    Delivery::DROPPED_BY_POLICY : Delivery::DELIVERED;
+        };
+    }
+    default:
+        return bufferSink_(std::shared_ptr<AbstractQueueBase<T>>(buffer),
+                policy);
+    }
+}
+
 /**
  * Unsubscribe from the channel.
+ * Once this returns, the subscriber won't be called any more - unless this is
+ * called by a subscriber of this channel, then the message that is being
+ * dispatched may still reach it.
  *
  * @param subscription the Subscription to unsubscribe
  */
 template<typename T>
 inline void Channel<T>::unsubscribe(const Subscription& subscription) {
-    std::lock_guard<std::mutex> lock(mtxSubscribers);
-    subscribers.erase(subscription.getID());
+    {
+        std::lock_guard<std::mutex> lock(mtxSubscribers);
+        subscribers.erase(subscription.getID());
+        buffers.erase(subscription.getID());
+        for (auto it = pendingReplays.begin(); it != pendingReplays.end();
+                ++it) {
+            if (it->first == subscription.getID()) {
+                pendingReplays.erase(it);
+                break;
+            }
+        }
+        publishSubscribers_();
+    }
+
+    // wait for dispatches that still use the old snapshot - but not for our
+    // own, that would never finish
+    if (!subscriberSnapshot.isReadByThisThread()) {
+        subscriberSnapshot.synchronize();
+    }
+}
+
+/**
+ * Replaces the snapshot read by the processing task with a copy of the
+ * current subscribers.
+ * @pre caller must hold mtxSubscribers!
+ */
+template<typename T>
+inline void Channel<T>::publishSubscribers_() {
+    std::unique_ptr<SubscriberList> snapshot(
+            new SubscriberList(subscribers.begin(), subscribers.end()));
+    subscriberSnapshot.update(std::move(snapshot));
+}
+
+/**
+ * Makes sure a subscriber can be added.
+ * A message of a move-only type can't be copied, so it can only be passed to
+ * a single subscriber.
+ * @pre caller must hold mtxSubscribers!
+ *
+ * @throws std::logic_error if T is move-only and there already is a subscriber
+ */
+template<typename T>
+inline void Channel<T>::checkCanSubscribe_() {
+    if (!std::is_copy_constructible<T>::value && !subscribers.empty()) {
+        throw std::logic_error("Channel \"" + name
+                + "\" has a move-only type and can't have a second subscriber");
+    }
+}
+
+/**
+ * @param message the message to copy
+ * @return a copy of message
+ */
+template<typename T>
+template<typename U>
+inline typename std::enable_if<std::is_copy_constructible<U>::value, U>::type Channel<
+        T>::copyMessage(const U& message) {
+    return message;
+}
+
+/**
+ * Overload for move-only types - never called, because checkCanSubscribe_
+ * prevents a second subscriber.
+ *
+ * @throws std::logic_error always
+ */
+template<typename T>
+template<typename U>
+inline typename std::enable_if<!std::is_copy_constructible<U>::value, U>::type Channel<
+        T>::copyMessage(const U&) {
+    throw std::logic_error("Can't copy a message of a move-only type");
 }
 
 /**
@@ -275,6 +1424,214 @@ inline std::string Channel<T>::getName() {
     return name;
 }
 
+/**
+ * Makes the channel keep the latest messages and replay them to every new
+ * subscriber, before any live message.
+ * Only available for copyable types.
+ *
+ * @param size the number of messages to keep - 0 disables the history
+ */
+template<typename T>
+inline void Channel<T>::setHistorySize(std::size_t size) {
+    static_assert(std::is_copy_constructible<T>::value,
+            "Only copyable messages can be replayed");
+    historySize = size;
+}
+
+/**
+ * Selects how messages of different Severity are ordered.
+ * With LaneScheduling::STRICT or LaneScheduling::WEIGHTED, Severity::ERROR
+ * messages get their own queue, so they neither wait behind nor are blocked
+ * by a burst of Severity::WARNING messages. Messages are then only delivered
+ * in publishing order within the same Severity.
+ * @attention change it before publishing - messages in flight while it is
+ *            changed may be reordered
+ *
+ * @param scheduling how to order the messages
+ * @param weight for LaneScheduling::WEIGHTED: the number of Severity::ERROR
+ *               publications dispatched for every Severity::WARNING one, if
+ *               both are waiting
+ */
+template<typename T>
+inline void Channel<T>::setLaneScheduling(LaneScheduling scheduling,
+        unsigned weight) {
+    priorityWeight = std::max(weight, 1u);
+    laneScheduling = scheduling;
+}
+
+/**
+ * Makes the publishing threads dispatch their messages themselves, instead of
+ * the executor. This saves the hand-over to a worker for every message, but
+ * publish only returns after all subscribers got the message - so it only
+ * pays off for short callbacks.
+ * Messages are still dispatched by one thread at a time, in publishing order.
+ * Messages that callbacks publish to this channel are dispatched after the
+ * current message, on the same thread. tryPublish fails while another thread
+ * is dispatching. LaneScheduling doesn't apply, and the history is only
+ * replayed to new subscribers along with the next message.
+ * @attention change it before publishing - messages in flight while it is
+ *            changed may be reordered
+ * @attention a callback must not wait for another thread that publishes to
+ *            this channel
+ *
+ * @param enable true to dispatch on the publishing threads
+ */
+template<typename T>
+inline void Channel<T>::setInlineDispatch(bool enable) {
+    inlineDispatch = enable;
+}
+
+/**
+ * Changes how publishers wait for space if the publishing queue is full.
+ * How fast the channel is processed after a publish depends on how the
+ * workers of its Executor wait, see Executor::setWaitStrategy.
+ * @attention change it before publishing
+ *
+ * @param strategy the new WaitStrategy
+ */
+template<typename T>
+inline void Channel<T>::setWaitStrategy(WaitStrategy strategy) {
+    publishingQueue.setWaitStrategy(strategy);
+    priorityQueue.setWaitStrategy(strategy);
+}
+
+/**
+ * Makes the channel pass every message to partitions of its subscribers in
+ * parallel, on the workers of its executor. Each subscriber still gets the
+ * messages in order: all partitions finish a message before the next one is
+ * dispatched. Only pays off for many subscribers and an executor with idle
+ * workers - every partition gets its own copy of the message.
+ * Doesn't apply to inline dispatch.
+ *
+ * @param partitions number of partitions - 0 or 1 dispatches sequentially
+ */
+template<typename T>
+inline void Channel<T>::setParallelFanOut(std::size_t partitions) {
+    static_assert(std::is_copy_constructible<T>::value,
+            "Only copyable messages can be dispatched in parallel");
+    fanOutPartitions = partitions;
+}
+
+/**
+ * Makes the channel keep the latest published message, for getLatest.
+ * The message is stored by the publishing thread, so it is available even if
+ * there are no subscribers or the processing is behind.
+ * Only available for trivially copyable types.
+ */
+template<typename T>
+inline void Channel<T>::enableLatest() {
+    static_assert(std::is_trivially_copyable<T>::value,
+            "Only trivially copyable messages can be kept as latest value");
+
+    SeqLockCell<T>* cell = new SeqLockCell<T>();
+    SeqLockCell<T>* expected = nullptr;
+    if (!latest.compare_exchange_strong(expected, cell)) {
+        // already enabled
+        delete cell;
+    }
+}
+
+/**
+ * Get the latest published message without waiting for the publisher.
+ * If several threads publish concurrently, it's the message of the publisher
+ * that stored it last.
+ *
+ * @return the latest message, or an empty optional if nothing was published
+ *         since enableLatest was called
+ *
+ * @throws std::logic_error if enableLatest wasn't called
+ */
+template<typename T>
+inline std::experimental::optional<T> Channel<T>::getLatest() {
+    SeqLockCell<T>* cell = latest.load(std::memory_order_acquire);
+    if (!cell) {
+        throw std::logic_error("Channel \"" + name
+                + "\" doesn't keep the latest message - call enableLatest first");
+    }
+    return cell->load();
+}
+
+/**
+ * Stores a message as the latest one, if enabled.
+ *
+ * @param message the message
+ */
+template<typename T>
+template<typename U>
+inline typename std::enable_if<std::is_trivially_copyable<U>::value>::type Channel<
+        T>::storeLatest_(const U& message) {
+    SeqLockCell<T>* cell = latest.load(std::memory_order_acquire);
+    if (cell) {
+        cell->store(message);
+    }
+}
+
+/**
+ * Overload for types that can't be kept as latest value - does nothing.
+ */
+template<typename T>
+template<typename U>
+inline typename std::enable_if<!std::is_trivially_copyable<U>::value>::type Channel<
+        T>::storeLatest_(const U&) {
+}
+
+/**
+ * Enables or disables tracking of latencies.
+ * While enabled, every message is timestamped when it is published, when it is
+ * passed to a subscriber and when it is put into a subscription's buffer.
+ *
+ * @param enable true to track latencies
+ */
+template<typename T>
+inline void Channel<T>::setLatencyTracking(bool enable) {
+    queueWaitHistogram.setEnabled(enable);
+    dispatchHistogram.setEnabled(enable);
+    dwellHistogram->setEnabled(enable);
+}
+
+/**
+ * @return the current statistics of the channel and its buffers
+ */
+template<typename T>
+inline ChannelStats Channel<T>::getStats() {
+    ChannelStats stats;
+    stats.channel = name;
+    counters.fill(stats);
+    stats.queueDepth = publishingQueue.size() + priorityQueue.size();
+    stats.peakQueueDepth = std::max(stats.peakQueueDepth, stats.queueDepth);
+    stats.queueCapacity = publishingQueue.capacity();
+    if (laneScheduling.load() != LaneScheduling::FIFO) {
+        // the priority lane is only used with priority scheduling
+        stats.queueCapacity += priorityQueue.capacity();
+    }
+
+    std::lock_guard<std::mutex> lock(mtxSubscribers);
+    for (auto&& subscriber : subscribers) {
+        SubscriptionStats subscription { subscriber.first, 0, 0, 0, 0, 0 };
+        subscriber.second.counters->fill(subscription);
+        auto buffer = buffers.find(subscriber.first);
+        if (buffer != buffers.end()) {
+            subscription.depth = buffer->second->size();
+            subscription.capacity = buffer->second->capacity();
+        }
+        stats.subscriptions.push_back(subscription);
+    }
+    return stats;
+}
+
+/**
+ * @return snapshots of the latencies tracked so far
+ */
+template<typename T>
+inline ChannelLatency Channel<T>::getLatency() {
+    ChannelLatency latency;
+    latency.channel = name;
+    latency.queueWait = queueWaitHistogram.getSnapshot();
+    latency.dispatch = dispatchHistogram.getSnapshot();
+    latency.dwell = dwellHistogram->getSnapshot();
+    return latency;
+}
+
 /**
  * Print the Severity to an ostream.
  *
@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_CHANNELREGISTRY_H_
+#define BROKING_CHANNELREGISTRY_H_
+
+#include "broking/AbstractChannelBase.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+
+namespace broking {
+
+/**
+ * Number of hash buckets in the ChannelRegistry
+ */
+constexpr std::size_t CHANNEL_REGISTRY_BUCKETS = 1024;
+
+/**
+ * Number of mutexes the buckets are distributed across for inserting
+ */
+constexpr std::size_t CHANNEL_REGISTRY_SHARDS = 64;
+
+/**
+ * Hash table of all channels, optimized for concurrent lookups.
+ *
+ * Channels are never removed, so every bucket is a singly linked list that
+ * only grows at its head. Lookups of existing channels just follow the list
+ * without taking any lock. Inserting takes the mutex of the bucket's shard.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class ChannelRegistry {
+public:
+    /**
+     * A registered channel - immutable once it is visible to lookups.
+     */
+    struct Entry {
+        std::string name; ///< the name of the channel
+        std::size_t hash; ///< hash of the name
+        std::type_index type; ///< the type of the channel's messages
+        std::unique_ptr<AbstractChannelBase> channel; ///< the channel
+        Entry* next; ///< next entry in the same bucket
+    };
+
+private:
+    std::atomic<Entry*> buckets[CHANNEL_REGISTRY_BUCKETS]; ///< heads of the bucket lists
+    std::mutex mtxShards[CHANNEL_REGISTRY_SHARDS]; ///< serialize inserts per shard
+public:
+    ChannelRegistry();
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    ChannelRegistry(const ChannelRegistry&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    ChannelRegistry(ChannelRegistry&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    ChannelRegistry& operator=(const ChannelRegistry&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    ChannelRegistry& operator=(ChannelRegistry&&) = delete;
+
+    virtual ~ChannelRegistry();
+
+    Entry* find(const std::string& name);
+    Entry& findOrCreate(const std::string& name, std::type_index type,
+            const std::function<AbstractChannelBase*(void)>& create);
+    void forEach(const std::function<void(Entry&)>& visitor);
+
+private:
+    static Entry* findInBucket(Entry* head, const std::string& name,
+            std::size_t hash);
+};
+
+} /* namespace broking */
+
+#endif /* BROKING_CHANNELREGISTRY_H_ */
+/** @} */
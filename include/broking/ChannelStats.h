@@ -0,0 +1,295 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_CHANNELSTATS_H_
+#define BROKING_CHANNELSTATS_H_
+
+#include "util/util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace broking {
+
+/**
+ * Counters of one subscriber of a channel, and the state of its buffer if it
+ * is a BufferedSubscription.
+ */
+struct SubscriptionStats {
+    int id; ///< ID of the Subscription
+    std::uint64_t delivered; ///< number of messages the subscriber got
+    std::uint64_t dropped; ///< number of messages the subscriber didn't accept - handled according to their Severity
+    std::uint64_t droppedByPolicy; ///< number of messages dropped or replaced by the subscriber's OverflowPolicy
+    std::size_t depth; ///< number of buffered messages - 0 for a callback
+    std::size_t capacity; ///< size of the buffer - 0 for a callback
+};
+
+/**
+ * Counters of one channel at one point in time.
+ */
+struct ChannelStats {
+    std::string channel; ///< name of the channel
+    std::uint64_t published; ///< number of published messages
+    std::uint64_t delivered; ///< number of messages passed to a subscriber - each message counts once per subscriber, as delivered or as dropped
+    std::uint64_t droppedWarnings; ///< number of dropped messages with Severity::WARNING
+    std::uint64_t droppedErrors; ///< number of dropped messages with Severity::ERROR
+    std::uint64_t droppedByPolicy; ///< number of messages dropped or replaced by an OverflowPolicy
+    std::size_t queueDepth; ///< number of entries in the publishing queue
+    std::size_t peakQueueDepth; ///< largest number of entries in the publishing queue
+    std::size_t queueCapacity; ///< actual size of the publishing queue (PUBLISHING_QUEUE_SIZE rounded up to a power of two) - including the priority lane if LaneScheduling isn't FIFO
+    std::uint64_t blockedPublishes; ///< number of publishes that had to wait for space
+    std::chrono::nanoseconds blockedTime; ///< total time publishers waited for space
+    std::vector<SubscriptionStats> subscriptions; ///< one per subscriber, ordered by ID
+};
+
+/**
+ * Counters a channel updates while it works.
+ *
+ * All counters are relaxed atomics - they are only meant for monitoring and
+ * don't order anything. Counters written by publishers and counters written
+ * by the processing task live on separate cache lines.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class ChannelCounters {
+private:
+    char padFront[CACHE_LINE_SIZE]; ///< keeps the counters apart from whatever precedes them
+
+    // written by publishers
+    std::atomic<std::uint64_t> published; ///< number of published messages
+    std::atomic<std::uint64_t> blockedPublishes; ///< number of publishes that had to wait
+    std::atomic<std::uint64_t> blockedNanoseconds; ///< total time publishers waited
+    char padPublishers[CACHE_LINE_SIZE]; ///< keeps the groups on separate cache lines
+
+    // written by the processing task
+    std::atomic<std::uint64_t> delivered; ///< number of messages passed to a subscriber
+    std::atomic<std::uint64_t> droppedWarnings; ///< number of dropped non critical messages
+    std::atomic<std::uint64_t> droppedErrors; ///< number of dropped critical messages
+    std::atomic<std::uint64_t> droppedByPolicy; ///< number of messages dropped by an OverflowPolicy
+    std::atomic<std::size_t> peakQueueDepth; ///< largest depth of the publishing queue
+    char padProcessing[CACHE_LINE_SIZE]; ///< keeps the counters apart from whatever follows
+public:
+    ChannelCounters();
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    ChannelCounters(const ChannelCounters&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    ChannelCounters(ChannelCounters&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    ChannelCounters& operator=(const ChannelCounters&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    ChannelCounters& operator=(ChannelCounters&&) = delete;
+
+    void countPublished(std::uint64_t messages);
+    void countBlocked(std::chrono::steady_clock::duration time);
+    void countDelivered();
+    void countDroppedWarning();
+    void countDroppedError();
+    void countDroppedByPolicy();
+    void updatePeakQueueDepth(std::size_t depth);
+
+    void fill(ChannelStats& stats) const;
+};
+
+/**
+ * Counters of one subscriber, updated by the processing task.
+ *
+ * Like ChannelCounters, all counters are relaxed atomics. Subscribers of a
+ * channel that dispatches in parallel are counted by different workers, so
+ * the counters are padded to a cache line of their own.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class SubscriberCounters {
+private:
+    char padFront[CACHE_LINE_SIZE]; ///< keeps the counters apart from whatever precedes them
+    std::atomic<std::uint64_t> delivered; ///< number of messages the subscriber got
+    std::atomic<std::uint64_t> dropped; ///< number of messages the subscriber didn't accept
+    std::atomic<std::uint64_t> droppedByPolicy; ///< number of messages dropped by the OverflowPolicy
+    char padBack[CACHE_LINE_SIZE]; ///< keeps the counters apart from whatever follows
+public:
+    SubscriberCounters();
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    SubscriberCounters(const SubscriberCounters&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    SubscriberCounters(SubscriberCounters&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    SubscriberCounters& operator=(const SubscriberCounters&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    SubscriberCounters& operator=(SubscriberCounters&&) = delete;
+
+    void countDelivered();
+    void countDropped();
+    void countDroppedByPolicy();
+
+    void fill(SubscriptionStats& stats) const;
+};
+
+/**
+ * Constructs ChannelCounters that are all 0.
+ */
+inline ChannelCounters::ChannelCounters() :
+        published(0), blockedPublishes(0), blockedNanoseconds(0), delivered(0), droppedWarnings(
+                0), droppedErrors(0), droppedByPolicy(0), peakQueueDepth(0) {
+}
+
+/**
+ * @param messages number of messages that were published
+ */
+inline void ChannelCounters::countPublished(std::uint64_t messages) {
+    published.fetch_add(messages, std::memory_order_relaxed);
+}
+
+/**
+ * @param time time a publisher waited for space in the publishing queue
+ */
+inline void ChannelCounters::countBlocked(
+        std::chrono::steady_clock::duration time) {
+    blockedPublishes.fetch_add(1, std::memory_order_relaxed);
+    blockedNanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(),
+            std::memory_order_relaxed);
+}
+
+/**
+ * Counts a message that was passed to a subscriber.
+ */
+inline void ChannelCounters::countDelivered() {
+    delivered.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Counts a dropped message with Severity::WARNING.
+ */
+inline void ChannelCounters::countDroppedWarning() {
+    droppedWarnings.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Counts a dropped message with Severity::ERROR.
+ */
+inline void ChannelCounters::countDroppedError() {
+    droppedErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Counts a message that was dropped or replaced by an OverflowPolicy.
+ */
+inline void ChannelCounters::countDroppedByPolicy() {
+    droppedByPolicy.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Remembers depth if it is the largest one so far.
+ * @attention only one thread at a time may call this
+ *
+ * @param depth the current depth of the publishing queue
+ */
+inline void ChannelCounters::updatePeakQueueDepth(std::size_t depth) {
+    if (depth > peakQueueDepth.load(std::memory_order_relaxed)) {
+        peakQueueDepth.store(depth, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Copies the counters to stats.
+ *
+ * @param stats the ChannelStats to fill
+ */
+inline void ChannelCounters::fill(ChannelStats& stats) const {
+    stats.published = published.load(std::memory_order_relaxed);
+    stats.delivered = delivered.load(std::memory_order_relaxed);
+    stats.droppedWarnings = droppedWarnings.load(std::memory_order_relaxed);
+    stats.droppedErrors = droppedErrors.load(std::memory_order_relaxed);
+    stats.droppedByPolicy = droppedByPolicy.load(std::memory_order_relaxed);
+    stats.peakQueueDepth = peakQueueDepth.load(std::memory_order_relaxed);
+    stats.blockedPublishes = blockedPublishes.load(std::memory_order_relaxed);
+    stats.blockedTime = std::chrono::nanoseconds(
+            blockedNanoseconds.load(std::memory_order_relaxed));
+}
+
+/**
+ * Constructs SubscriberCounters that are all 0.
+ */
+inline SubscriberCounters::SubscriberCounters() :
+        delivered(0), dropped(0), droppedByPolicy(0) {
+}
+
+/**
+ * Counts a message that the subscriber got.
+ */
+inline void SubscriberCounters::countDelivered() {
+    delivered.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Counts a message that the subscriber didn't accept.
+ */
+inline void SubscriberCounters::countDropped() {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Counts a message that was dropped or replaced by the subscriber's
+ * OverflowPolicy.
+ */
+inline void SubscriberCounters::countDroppedByPolicy() {
+    droppedByPolicy.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Copies the counters to stats.
+ *
+ * @param stats the SubscriptionStats to fill
+ */
+inline void SubscriberCounters::fill(SubscriptionStats& stats) const {
+    stats.delivered = delivered.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.droppedByPolicy = droppedByPolicy.load(std::memory_order_relaxed);
+}
+
+} /* namespace broking */
+
+#endif /* BROKING_CHANNELSTATS_H_ */
+/** @} */
@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_EXECUTOR_H_
+#define BROKING_EXECUTOR_H_
+
+#include "broking/WaitStrategy.h"
+
+#include <atomic>
+#include <cstddef>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace broking {
+
+/**
+ * Time an elastic worker stays idle before it terminates.
+ */
+constexpr std::chrono::milliseconds ELASTIC_WORKER_IDLE_TIMEOUT(1000);
+
+/**
+ * Pool of worker threads that runs tasks in FIFO order.
+ *
+ * Workers are started on demand up to the worker count. If a maximum worker
+ * count above the worker count is set, the pool is elastic: when all workers
+ * are busy, additional workers are started up to that maximum and terminate
+ * again after being idle for ELASTIC_WORKER_IDLE_TIMEOUT.
+ *
+ * A worker that waits for other tasks, e.g. a callback that publishes to a
+ * full channel, marks itself with a Blocking section. While it is blocked, an
+ * additional worker may be started, so the tasks it waits for can't be
+ * starved by a pool that is busy waiting.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class Executor {
+public:
+    /**
+     * Marks the calling thread as blocked while it exists, if it is a worker
+     * of an Executor - otherwise it does nothing.
+     */
+    class Blocking {
+    private:
+        Executor* executor; ///< the Executor of the calling worker, if any
+    public:
+        Blocking();
+
+        /**
+         * Delete Copy-Constructor
+         */
+        Blocking(const Blocking&) = delete;
+
+        /**
+         * Delete Copy-Assignment
+         */
+        Blocking& operator=(const Blocking&) = delete;
+
+        ~Blocking();
+    };
+
+private:
+    std::mutex mtxTasks; ///< protects all members below
+    std::condition_variable cvTasks; ///< workers wait on this for new tasks
+    std::deque<std::function<void(void)>> tasks; ///< tasks waiting for a worker
+    std::list<std::thread> workers; ///< handles of all running workers
+    std::list<std::thread> finishedWorkers; ///< handles of terminated workers, still to be joined
+    std::size_t workerCount; ///< number of workers that are kept alive
+    std::size_t maxWorkerCount; ///< upper limit for elastic workers
+    std::size_t idleWorkers; ///< number of workers waiting for a task
+    std::size_t parkedWorkers; ///< number of idle workers that wait on cvTasks
+    std::size_t blockedWorkers; ///< number of workers inside a Blocking section - each may be replaced by an additional worker
+    bool run; ///< flag for the worker loops
+    WaitStrategy waitStrategy; ///< how idle workers wait for tasks
+    std::atomic<unsigned long> signals; ///< incremented on every notification of cvTasks, for spinning workers
+public:
+    Executor(std::size_t workerCount = defaultWorkerCount(),
+            std::size_t maxWorkerCount = 0);
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    Executor(const Executor&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    Executor(Executor&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    Executor& operator=(Executor&&) = delete;
+
+    virtual ~Executor();
+
+    void execute(std::function<void(void)> task);
+
+    void setWorkerCount(std::size_t count);
+    void setMaxWorkerCount(std::size_t count);
+    void setWaitStrategy(WaitStrategy strategy);
+    std::size_t getWorkerCount();
+    std::size_t getThreadCount();
+
+    static std::size_t defaultWorkerCount();
+
+private:
+    void workerLoop();
+    void waitForTask_(std::unique_lock<std::mutex>& lock);
+    void signal_();
+    std::size_t workerLimit_();
+    void startWorker_();
+    void joinFinishedWorkers_();
+};
+
+} /* namespace broking */
+
+#endif /* BROKING_EXECUTOR_H_ */
+/** @} */
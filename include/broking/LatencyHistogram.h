@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_LATENCYHISTOGRAM_H_
+#define BROKING_LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace broking {
+
+/**
+ * Every power of two is split into 2^LATENCY_SUB_BUCKET_BITS buckets, which
+ * keeps the relative error of a recorded value below 12.5%.
+ */
+constexpr unsigned LATENCY_SUB_BUCKET_BITS = 3;
+
+/**
+ * Recorded values are clamped to 2^LATENCY_MAX_EXPONENT - 1 ns (about 18 min)
+ */
+constexpr unsigned LATENCY_MAX_EXPONENT = 40;
+
+/**
+ * Number of buckets of a LatencyHistogram
+ */
+constexpr std::size_t LATENCY_BUCKETS = (LATENCY_MAX_EXPONENT
+        - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS;
+
+/**
+ * Copy of the counters of a LatencyHistogram at one point in time.
+ */
+struct LatencySnapshot {
+    std::vector<std::uint64_t> buckets; ///< number of values per bucket
+    std::uint64_t count; ///< number of recorded values
+    std::uint64_t sum; ///< sum of all recorded values in ns
+    std::uint64_t max; ///< largest recorded value in ns
+
+    std::chrono::nanoseconds getPercentile(double fraction) const;
+    std::chrono::nanoseconds getMean() const;
+};
+
+/**
+ * Latencies of one channel, see Channel::setLatencyTracking.
+ */
+struct ChannelLatency {
+    std::string channel; ///< name of the channel
+    LatencySnapshot queueWait; ///< publish until the processing task picked the message up
+    LatencySnapshot dispatch; ///< time spent in a single subscriber
+    LatencySnapshot dwell; ///< time a message spent in a subscription's buffer
+};
+
+/**
+ * Histogram of latencies with logarithmic buckets.
+ *
+ * Recording only increments a few relaxed atomics, so any number of threads
+ * can record without locks. Recording is disabled by default - a disabled
+ * histogram doesn't even read the clock.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class LatencyHistogram {
+public:
+    /// point in time a latency starts - a default constructed one is not recorded
+    using Stamp = std::chrono::steady_clock::time_point;
+
+private:
+    std::atomic<bool> enabled; ///< true if values are recorded
+    std::atomic<Stamp::rep> enabledSince; ///< when recording was enabled last - older Stamps are stale and not recorded
+    std::atomic<std::uint64_t> count; ///< number of recorded values
+    std::atomic<std::uint64_t> sum; ///< sum of all recorded values in ns
+    std::atomic<std::uint64_t> max; ///< largest recorded value in ns
+    std::atomic<std::uint64_t> buckets[LATENCY_BUCKETS]; ///< number of values per bucket
+public:
+    LatencyHistogram();
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    LatencyHistogram(const LatencyHistogram&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    LatencyHistogram(LatencyHistogram&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    LatencyHistogram& operator=(LatencyHistogram&&) = delete;
+
+    virtual ~LatencyHistogram() = default;
+
+    void setEnabled(bool enable);
+    bool isEnabled() const;
+
+    Stamp stamp() const;
+    void recordSince(Stamp start);
+    void record(std::chrono::nanoseconds latency);
+
+    LatencySnapshot getSnapshot() const;
+    void reset();
+
+    static std::size_t bucketOf(std::uint64_t nanoseconds);
+    static std::uint64_t upperBoundOf(std::size_t bucket);
+};
+
+/**
+ * @return the current time if recording is enabled, a Stamp that is ignored
+ *         by recordSince otherwise
+ */
+inline LatencyHistogram::Stamp LatencyHistogram::stamp() const {
+    return enabled.load(std::memory_order_relaxed) ?
+            std::chrono::steady_clock::now() : Stamp();
+}
+
+/**
+ * Records the time elapsed since start.
+ *
+ * @param start a Stamp created by stamp() - ignored if recording was disabled
+ *              or has been re-enabled since
+ */
+inline void LatencyHistogram::recordSince(Stamp start) {
+    if (start != Stamp()
+            && start.time_since_epoch().count()
+                    >= enabledSince.load(std::memory_order_relaxed)) {
+        record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start));
+    }
+}
+
+} /* namespace broking */
+
+#endif /* BROKING_LATENCYHISTOGRAM_H_ */
+/** @} */
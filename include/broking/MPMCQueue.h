@@ -0,0 +1,458 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_MPMCQUEUE_H_
+#define BROKING_MPMCQUEUE_H_
+
+#include "broking/WaitStrategy.h"
+#include "util/optional.hpp"
+#include "util/util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <condition_variable>
+
+namespace broking {
+
+/**
+ * A bounded lock-free queue for any number of producer and consumer threads.
+ *
+ * Every slot carries a sequence number that tells producers and consumers
+ * whether it is free or filled for their position, so a successful operation
+ * costs one compare-and-swap on the shared position counter. Mutexes are only
+ * used to park threads in the blocking operations.
+ * If constructing an element throws, its slot is left empty and skipped by
+ * the consumers, so the queue stays usable.
+ *
+ * @attention the capacity is rounded up to the next power of two
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename T> class MPMCQueue {
+private:
+    /**
+     * A slot of the ring
+     */
+    struct Cell {
+        std::atomic<std::size_t> sequence; ///< position the slot is ready for
+        bool filled; ///< false if constructing the element threw - published by sequence
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage; ///< the element
+    };
+
+    std::size_t mask; ///< capacity - 1, to map positions to slots
+    std::unique_ptr<Cell[]> cells; ///< the ring of slots
+    std::mutex mtxDequeueWait; ///< protects parking of consumers
+    std::mutex mtxEnqueueWait; ///< protects parking of producers
+    std::condition_variable cvDequeue; ///< consumers wait on this if the queue is empty
+    std::condition_variable cvEnqueue; ///< producers wait on this if the queue is full
+    std::atomic<int> dequeueWaiters; ///< number of parked consumers
+    std::atomic<int> enqueueWaiters; ///< number of parked producers
+    WaitStrategy waitStrategy; ///< how blocked producers and consumers wait
+    char padShared[CACHE_LINE_SIZE]; ///< keeps the shared members above apart from the positions
+
+    std::atomic<std::size_t> enqueuePos; ///< next position to enqueue into
+    char padEnqueue[CACHE_LINE_SIZE]; ///< keeps the positions on separate cache lines
+    std::atomic<std::size_t> dequeuePos; ///< next position to dequeue from
+    char padDequeue[CACHE_LINE_SIZE]; ///< keeps dequeuePos apart from whatever follows
+public:
+    MPMCQueue(int size);
+
+    // prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    MPMCQueue(const MPMCQueue&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    MPMCQueue(MPMCQueue&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    MPMCQueue& operator=(MPMCQueue&&) = delete;
+
+    virtual ~MPMCQueue();
+
+    bool canEnqueue();
+    bool canDequeue();
+
+    bool tryEnqueue(T message);
+    void enqueue(T message);
+    template<typename ... Args> bool tryEmplace(Args&&... args);
+    template<typename ... Args> void emplace(Args&&... args);
+
+    std::experimental::optional<T> tryDequeue();
+    T dequeue();
+
+    std::size_t capacity() const;
+    std::size_t size() const;
+
+    void setWaitStrategy(WaitStrategy strategy);
+
+private:
+    static std::size_t roundUpToPowerOfTwo(std::size_t size);
+    T* element(Cell& cell);
+    void wakeConsumer();
+    void wakeProducer();
+};
+
+/**
+ * Constructs a MPMCQueue<T>.
+ *
+ * @param size the (maximum) size of the queue - rounded up to a power of two
+ */
+template<typename T>
+inline MPMCQueue<T>::MPMCQueue(int size) :
+        mask(roundUpToPowerOfTwo(size) - 1), cells(new Cell[mask + 1]), dequeueWaiters(
+                0), enqueueWaiters(0), enqueuePos(0), dequeuePos(0) {
+    for (std::size_t i = 0; i <= mask; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Destructs a MPMCQueue.
+ * Destroys all elements that are still queued.
+ */
+template<typename T>
+inline MPMCQueue<T>::~MPMCQueue() {
+    while (tryDequeue()) {
+    }
+}
+
+/**
+ * Non-blocking enqueue.
+ *
+ * @param message the message to enqueue
+ * @retval true successfully enqueued
+ * @retval false unable to enqueue
+ */
+template<typename T>
+inline bool MPMCQueue<T>::tryEnqueue(T message) {
+    return tryEmplace(std::move(message));
+}
+
+/**
+ * Enqueue a message.
+ * @attention will BLOCK if there is no space
+ *
+ * @param message the message to enqueue
+ */
+template<typename T>
+inline void MPMCQueue<T>::enqueue(T message) {
+    emplace(std::move(message));
+}
+
+/**
+ * Enqueue a message that is constructed in place.
+ * @attention will BLOCK if there is no space
+ *
+ * @param args the arguments to construct the message from
+ */
+template<typename T>
+template<typename ... Args>
+inline void MPMCQueue<T>::emplace(Args&&... args) {
+    // tryEmplace only consumes the arguments on success, so forwarding them
+    // again is fine
+    while (!tryEmplace(std::forward<Args>(args)...)) {
+        if (waitStrategy.spinUntil([this]() {return canEnqueue();})
+                || !waitStrategy.parks()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mtxEnqueueWait);
+        enqueueWaiters.fetch_add(1);
+        // pairs with the fence in wakeProducer
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!canEnqueue()) {
+            cvEnqueue.wait(lock);
+        }
+        enqueueWaiters.fetch_sub(1);
+    }
+}
+
+/**
+ * Non-blocking enqueue that constructs the message in place.
+ * The arguments are only consumed if there is space.
+ *
+ * @param args the arguments to construct the message from
+ * @retval true successfully enqueued
+ * @retval false unable to enqueue
+ * @throws whatever constructing the message throws - nothing is enqueued then
+ */
+template<typename T>
+template<typename ... Args>
+inline bool MPMCQueue<T>::tryEmplace(Args&&... args) {
+    Cell* cell;
+    std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        cell = &cells[pos & mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence)
+                - static_cast<std::intptr_t>(pos);
+        if (diff == 0) {
+            // slot is free for this position - try to claim it
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // slot still holds the element from one lap ago -> full
+            return false;
+        } else {
+            // another producer claimed the position
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    try {
+        new (&cell->storage) T(std::forward<Args>(args)...);
+    } catch (...) {
+        // the position is claimed already - hand the empty slot to the
+        // consumers, so they skip it instead of waiting for it forever
+        cell->filled = false;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        wakeConsumer();
+        throw;
+    }
+    cell->filled = true;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    wakeConsumer();
+    return true;
+}
+
+/**
+ * Non-Blocking dequeue.
+ * @return the message wrapped in an optional, or an empty optional if there is
+ *         no message to dequeue
+ */
+template<typename T>
+inline std::experimental::optional<T> MPMCQueue<T>::tryDequeue() {
+    Cell* cell;
+    std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+        cell = &cells[pos & mask];
+        std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence)
+                - static_cast<std::intptr_t>(pos + 1);
+        if (diff == 0) {
+            // slot is filled for this position - try to claim it
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed)) {
+                if (cell->filled) {
+                    break;
+                }
+                // constructing the element threw - free the slot and go on
+                cell->sequence.store(pos + mask + 1,
+                        std::memory_order_release);
+                wakeProducer();
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        } else if (diff < 0) {
+            // slot not filled yet -> empty
+            return std::experimental::nullopt;
+        } else {
+            // another consumer claimed the position
+            pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    T* message = element(*cell);
+    std::experimental::optional<T> result(std::move(*message));
+    message->~T();
+    // free the slot for the producer one lap ahead
+    cell->sequence.store(pos + mask + 1, std::memory_order_release);
+
+    wakeProducer();
+    return result;
+}
+
+/**
+ * Dequeue a message.
+ * @attention will BLOCK if there is no message to dequeue
+ *
+ * @return the message
+ */
+template<typename T>
+inline T MPMCQueue<T>::dequeue() {
+    while (true) {
+        auto message = tryDequeue();
+        if (message) {
+            return std::move(*message);
+        }
+        if (waitStrategy.spinUntil([this]() {return canDequeue();})
+                || !waitStrategy.parks()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mtxDequeueWait);
+        dequeueWaiters.fetch_add(1);
+        // pairs with the fence in wakeConsumer
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!canDequeue()) {
+            cvDequeue.wait(lock);
+        }
+        dequeueWaiters.fetch_sub(1);
+    }
+}
+
+/**
+ * Checks if there is a message to be dequeued
+ *
+ * @retval true there is a message to be dequeued
+ * @retval false there is no message to be dequeued
+ */
+template<typename T>
+inline bool MPMCQueue<T>::canDequeue() {
+    std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+        std::size_t sequence = cells[pos & mask].sequence.load(
+                std::memory_order_acquire);
+        if (sequence == pos + 1) {
+            return true;
+        }
+        std::size_t current = dequeuePos.load(std::memory_order_relaxed);
+        if (current == pos) {
+            // nobody moved on -> the slot really isn't filled yet
+            return false;
+        }
+        pos = current;
+    }
+}
+
+/**
+ * Checks if there is a space for a message
+ *
+ * @retval true there is space for a message to be queued
+ * @retval false there is no space for a message to be queued
+ */
+template<typename T>
+inline bool MPMCQueue<T>::canEnqueue() {
+    std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        std::size_t sequence = cells[pos & mask].sequence.load(
+                std::memory_order_acquire);
+        if (sequence == pos) {
+            return true;
+        }
+        std::size_t current = enqueuePos.load(std::memory_order_relaxed);
+        if (current == pos) {
+            // nobody moved on -> the slot really isn't free yet
+            return false;
+        }
+        pos = current;
+    }
+}
+
+/**
+ * @return the maximum number of messages in the queue
+ */
+template<typename T>
+inline std::size_t MPMCQueue<T>::capacity() const {
+    return mask + 1;
+}
+
+/**
+ * @return the approximate number of queued elements - includes elements that
+ *         are still being enqueued or dequeued
+ */
+template<typename T>
+inline std::size_t MPMCQueue<T>::size() const {
+    // read dequeuePos first, so enqueuePos can't be older
+    std::size_t dequeued = dequeuePos.load(std::memory_order_relaxed);
+    std::size_t enqueued = enqueuePos.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? std::min(enqueued - dequeued, capacity()) : 0;
+}
+
+/**
+ * Changes how producers wait for space in enqueue and consumers for messages
+ * in dequeue.
+ * @attention don't change it while a thread is waiting
+ *
+ * @param strategy the new WaitStrategy
+ */
+template<typename T>
+inline void MPMCQueue<T>::setWaitStrategy(WaitStrategy strategy) {
+    waitStrategy = strategy;
+}
+
+/**
+ * @param size a size
+ * @return the smallest power of two that is not less than size (at least 2)
+ */
+template<typename T>
+inline std::size_t MPMCQueue<T>::roundUpToPowerOfTwo(std::size_t size) {
+    std::size_t result = 2;
+    while (result < size) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * @param cell a slot of the ring
+ * @return pointer to the element constructed in that slot
+ */
+template<typename T>
+inline T* MPMCQueue<T>::element(Cell& cell) {
+    return reinterpret_cast<T*>(&cell.storage);
+}
+
+/**
+ * Wakes a parked consumer after an enqueue, if there is one.
+ */
+template<typename T>
+inline void MPMCQueue<T>::wakeConsumer() {
+    // pairs with the fence in dequeue - either we see the consumer parking or
+    // the consumer sees the new element
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (dequeueWaiters.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mtxDequeueWait);
+        cvDequeue.notify_one();
+    }
+}
+
+/**
+ * Wakes a parked producer after a dequeue, if there is one.
+ */
+template<typename T>
+inline void MPMCQueue<T>::wakeProducer() {
+    // pairs with the fence in enqueue - either we see the producer parking or
+    // the producer sees the free slot
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (enqueueWaiters.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mtxEnqueueWait);
+        cvEnqueue.notify_one();
+    }
+}
+
+} /* namespace broking */
+
+#endif /* BROKING_MPMCQUEUE_H_ */
+/** @} */
@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_OVERFLOWPOLICY_H_
+#define BROKING_OVERFLOWPOLICY_H_
+
+#include <chrono>
+#include <functional>
+
+namespace broking {
+
+/**
+ * What a subscription buffer does with a message it has no space for
+ */
+enum class OverflowAction {
+    FAIL, ///< reject the message - handled according to its Severity
+    DROP_NEWEST, ///< silently drop the new message
+    DROP_OLDEST, ///< drop the oldest buffered message to make space
+    BLOCK, ///< wait for space, up to a timeout - then FAIL
+    CONFLATE ///< replace a buffered message with the same key, or DROP_OLDEST
+};
+
+/**
+ * Describes how a BufferedSubscription handles a full buffer.
+ *
+ * An OverflowAction converts implicitly, use block and conflate for the
+ * actions that need parameters.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename T> struct OverflowPolicy {
+    OverflowAction action; ///< what to do if the buffer is full
+    std::chrono::steady_clock::duration timeout; ///< maximum time to wait for OverflowAction::BLOCK
+    std::function<bool(const T&, const T&)> sameKey; ///< compares the keys of two messages for OverflowAction::CONFLATE
+
+    /**
+     * Constructs an OverflowPolicy.
+     *
+     * @param action what to do if the buffer is full
+     */
+    OverflowPolicy(OverflowAction action = OverflowAction::FAIL) :
+            action(action), timeout(std::chrono::steady_clock::duration::zero()) {
+    }
+
+    /**
+     * @param timeout the maximum time to wait for space
+     * @return an OverflowPolicy that waits for space, up to timeout
+     * @attention the channel isn't processed while waiting
+     */
+    template<typename Rep, typename Period>
+    static OverflowPolicy block(
+            const std::chrono::duration<Rep, Period>& timeout) {
+        OverflowPolicy policy(OverflowAction::BLOCK);
+        policy.timeout = std::chrono::duration_cast<
+                std::chrono::steady_clock::duration>(timeout);
+        return policy;
+    }
+
+    /**
+     * A conflating buffer keeps at most one message per key: a new message
+     * replaces a buffered message with the same key in place. If there is
+     * none and the buffer is full, the oldest message is dropped.
+     *
+     * @param key returns the key of a message
+     * @return an OverflowPolicy that conflates messages by key
+     */
+    template<typename KeyFunction>
+    static OverflowPolicy conflate(KeyFunction key) {
+        OverflowPolicy policy(OverflowAction::CONFLATE);
+        policy.sameKey = [key](const T& a, const T& b) {
+            return key(a) == key(b);
+        };
+        return policy;
+    }
+};
+
+} /* namespace broking */
+
+#endif /* BROKING_OVERFLOWPOLICY_H_ */
+/** @} */
@@ -0,0 +1,308 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_PARTITIONEDCHANNEL_H_
+#define BROKING_PARTITIONEDCHANNEL_H_
+
+#include "broking/Channel.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace broking {
+
+/**
+ * Channel that is split into partitions by a key of the messages.
+ *
+ * Every partition is a Channel<T> of its own, so the partitions are processed
+ * by different workers in parallel. All messages with the same key go to the
+ * same partition, so they are delivered in publishing order - messages with
+ * different keys may be delivered in any order.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename T> class PartitionedChannel {
+private:
+    std::vector<std::unique_ptr<Channel<T>>> partitions; ///< the partitions
+    std::function<std::size_t(const T&)> hashKey; ///< hash of the key of a message
+    std::string name; ///< stores the name of the channel
+public:
+    template<typename KeyFunction>
+    PartitionedChannel(std::string name, std::size_t partitionCount,
+            KeyFunction key, Executor& executor = getSharedExecutor());
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    PartitionedChannel(const PartitionedChannel&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    PartitionedChannel(PartitionedChannel&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    PartitionedChannel& operator=(const PartitionedChannel&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    PartitionedChannel& operator=(PartitionedChannel&&) = delete;
+
+    void publish(const T& message, Severity severity = Severity::ERROR);
+    void publish(T&& message, Severity severity = Severity::ERROR);
+    template<typename ... Args> void emplace(Args&&... args);
+    bool tryPublish(const T& message, Severity severity = Severity::ERROR);
+    bool tryPublish(T&& message, Severity severity = Severity::ERROR);
+    void publish(std::vector<T>&& messages, Severity severity = Severity::ERROR);
+
+    std::vector<Subscription> subscribe(std::function<void(T)> callback);
+    std::vector<Subscription> subscribe(std::function<void(T)> callback,
+            const std::vector<std::size_t>& indices);
+
+    std::size_t getPartitionCount() const;
+    std::size_t partitionOf(const T& message) const;
+    Channel<T>& getPartition(std::size_t index);
+    std::string getName();
+};
+
+/**
+ * Constructs a PartitionedChannel<T>.
+ * The partitions are named like the channel, followed by their index in
+ * brackets.
+ *
+ * @param name the name of the channel
+ * @param partitionCount the number of partitions
+ * @param key returns the key of a message - the key type needs a std::hash
+ * @param executor the Executor that processes the partitions
+ *
+ * @throws std::logic_error if partitionCount is 0
+ */
+template<typename T>
+template<typename KeyFunction>
+inline PartitionedChannel<T>::PartitionedChannel(std::string name,
+        std::size_t partitionCount, KeyFunction key, Executor& executor) :
+        name(name) {
+    using Key = typename std::decay<decltype(key(std::declval<const T&>()))>::type;
+
+    if (partitionCount == 0) {
+        throw std::logic_error(
+                "PartitionedChannel \"" + name + "\" needs a partition");
+    }
+
+    hashKey = [key](const T& message) {
+        return std::hash<Key>()(key(message));
+    };
+    for (std::size_t i = 0; i < partitionCount; ++i) {
+        partitions.emplace_back(
+                new Channel<T>(name + "[" + std::to_string(i) + "]",
+                        executor));
+    }
+}
+
+/**
+ * Publish a message on the partition of its key.
+ *
+ * @param message the message to publish
+ * @param severity the Severity if the message is dropped.
+ * @attention this WILL block if the publishing queue of the partition is full!
+ */
+template<typename T>
+inline void PartitionedChannel<T>::publish(const T& message,
+        Severity severity) {
+    partitions[partitionOf(message)]->publish(message, severity);
+}
+
+/**
+ * Publish a message on the partition of its key by moving it.
+ *
+ * @param message the message to publish
+ * @param severity the Severity if the message is dropped.
+ * @attention this WILL block if the publishing queue of the partition is full!
+ */
+template<typename T>
+inline void PartitionedChannel<T>::publish(T&& message, Severity severity) {
+    partitions[partitionOf(message)]->publish(std::move(message), severity);
+}
+
+/**
+ * Publish a message that is constructed in place with Severity::ERROR.
+ * The message is constructed before it is passed to its partition, as the
+ * key is needed.
+ *
+ * @param args the arguments to construct the message from
+ * @attention this WILL block if the publishing queue of the partition is full!
+ */
+template<typename T>
+template<typename ... Args>
+inline void PartitionedChannel<T>::emplace(Args&&... args) {
+    publish(T(std::forward<Args>(args)...));
+}
+
+/**
+ * Publish a message on the partition of its key, unless its publishing queue
+ * is full.
+ *
+ * @param message the message to publish
+ * @param severity the Severity if the message is dropped.
+ * @retval true the message was published
+ * @retval false the publishing queue of the partition is full
+ */
+template<typename T>
+inline bool PartitionedChannel<T>::tryPublish(const T& message,
+        Severity severity) {
+    return partitions[partitionOf(message)]->tryPublish(message, severity);
+}
+
+/**
+ * Publish a message on the partition of its key by moving it, unless its
+ * publishing queue is full.
+ *
+ * @param message the message to publish - left untouched if the queue is full
+ * @param severity the Severity if the message is dropped.
+ * @retval true the message was published
+ * @retval false the publishing queue of the partition is full
+ */
+template<typename T>
+inline bool PartitionedChannel<T>::tryPublish(T&& message, Severity severity) {
+    return partitions[partitionOf(message)]->tryPublish(std::move(message),
+            severity);
+}
+
+/**
+ * Publish a batch of messages.
+ * The batch is split into one batch per partition, which keeps the order of
+ * the messages per key.
+ *
+ * @param messages the messages to publish
+ * @param severity the Severity if a message is dropped.
+ * @attention this WILL block if a publishing queue of a partition is full!
+ */
+template<typename T>
+inline void PartitionedChannel<T>::publish(std::vector<T>&& messages,
+        Severity severity) {
+    std::vector<std::vector<T>> batches(partitions.size());
+    for (auto&& message : messages) {
+        batches[partitionOf(message)].push_back(std::move(message));
+    }
+    messages.clear();
+
+    for (std::size_t i = 0; i < partitions.size(); ++i) {
+        partitions[i]->publish(std::move(batches[i]), severity);
+    }
+}
+
+/**
+ * Subscribe a callback on all partitions.
+ * @attention the callback is called from several workers at the same time -
+ *            it has to be thread safe
+ *
+ * @param callback the callback to subscribe
+ * @return a Subscription per partition - unsubscribe all to unsubscribe the
+ *         callback
+ */
+template<typename T>
+inline std::vector<Subscription> PartitionedChannel<T>::subscribe(
+        std::function<void(T)> callback) {
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < partitions.size(); ++i) {
+        indices.push_back(i);
+    }
+    return subscribe(std::move(callback), indices);
+}
+
+/**
+ * Subscribe a callback on some partitions.
+ * @attention with more than one partition, the callback is called from
+ *            several workers at the same time - it has to be thread safe
+ *
+ * @param callback the callback to subscribe
+ * @param indices the indices of the partitions
+ * @return a Subscription per partition, in the order of indices
+ *
+ * @throws std::out_of_range if an index is not below the partition count
+ */
+template<typename T>
+inline std::vector<Subscription> PartitionedChannel<T>::subscribe(
+        std::function<void(T)> callback,
+        const std::vector<std::size_t>& indices) {
+    // check all indices before subscribing anything
+    for (std::size_t index : indices) {
+        getPartition(index);
+    }
+
+    std::vector<Subscription> subscriptions;
+    for (std::size_t index : indices) {
+        subscriptions.push_back(partitions[index]->subscribe(callback));
+    }
+    return subscriptions;
+}
+
+/**
+ * @return the number of partitions
+ */
+template<typename T>
+inline std::size_t PartitionedChannel<T>::getPartitionCount() const {
+    return partitions.size();
+}
+
+/**
+ * @param message a message
+ * @return the index of the partition the message is published on
+ */
+template<typename T>
+inline std::size_t PartitionedChannel<T>::partitionOf(const T& message) const {
+    return hashKey(message) % partitions.size();
+}
+
+/**
+ * Gives access to a single partition, e.g. to subscribe a buffer or to get
+ * its statistics.
+ *
+ * @param index the index of the partition
+ * @return the partition
+ *
+ * @throws std::out_of_range if index is not below the partition count
+ */
+template<typename T>
+inline Channel<T>& PartitionedChannel<T>::getPartition(std::size_t index) {
+    if (index >= partitions.size()) {
+        throw std::out_of_range(
+                "PartitionedChannel \"" + name + "\" has no partition "
+                        + std::to_string(index));
+    }
+    return *partitions[index];
+}
+
+/**
+ * @return the name of the channel
+ */
+template<typename T>
+inline std::string PartitionedChannel<T>::getName() {
+    return name;
+}
+
+} /* namespace broking */
+
+#endif /* BROKING_PARTITIONEDCHANNEL_H_ */
+/** @} */
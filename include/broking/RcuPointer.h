@@ -0,0 +1,341 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_RCUPOINTER_H_
+#define BROKING_RCUPOINTER_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace broking {
+
+/**
+ * Marks a read section on the current thread, see RcuPointer.
+ */
+struct RcuReadSection {
+    const void* owner; ///< the RcuPointer that is read
+    RcuReadSection* outer; ///< the enclosing read section on this thread
+};
+
+/**
+ * @return the innermost read section of the current thread
+ */
+inline RcuReadSection*& innermostRcuReadSection() {
+    static thread_local RcuReadSection* section = nullptr;
+    return section;
+}
+
+/**
+ * Pointer to an immutable value that is read without locks and replaced as a
+ * whole (read-copy-update).
+ *
+ * Readers enter a read section, which only increments a counter for the
+ * current epoch. A replaced value is retired and deleted once the epoch has
+ * advanced twice, which is only possible after all readers that could have
+ * seen it have left their read section. Writers never wait for readers unless
+ * they call synchronize.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename V> class RcuPointer {
+public:
+    /**
+     * Read section - keeps the value that was current when it was created
+     * alive until it is destroyed.
+     */
+    class ReadGuard {
+    private:
+        RcuPointer* rcu; ///< the RcuPointer that is read
+        unsigned slot; ///< parity of the epoch the reader registered in
+        const V* value; ///< the value that was current
+        RcuReadSection section; ///< marks this read section on the thread
+    public:
+        ReadGuard(RcuPointer& rcu);
+
+        /**
+         * Delete Copy-Constructor
+         */
+        ReadGuard(const ReadGuard&) = delete;
+
+        /**
+         * Delete Copy-Assignment
+         */
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        ~ReadGuard();
+
+        const V& operator*() const;
+        const V* operator->() const;
+    };
+
+    /**
+     * Marks the current thread as reading on behalf of a ReadGuard on another
+     * thread, which keeps the value alive - e.g. for work that the reader
+     * handed to other threads and waits for.
+     * Only affects isReadByThisThread, the thread isn't registered as reader.
+     */
+    class ReadSectionMark {
+    private:
+        RcuReadSection section; ///< marks the read section on the thread
+    public:
+        ReadSectionMark(const RcuPointer& rcu);
+
+        /**
+         * Delete Copy-Constructor
+         */
+        ReadSectionMark(const ReadSectionMark&) = delete;
+
+        /**
+         * Delete Copy-Assignment
+         */
+        ReadSectionMark& operator=(const ReadSectionMark&) = delete;
+
+        ~ReadSectionMark();
+    };
+
+private:
+    std::atomic<const V*> current; ///< the current value
+    std::atomic<unsigned long> epoch; ///< only advanced by writers
+    std::atomic<int> readers[2]; ///< readers per epoch parity
+    std::atomic<bool> pendingRetired; ///< true if there are retired values
+    std::mutex mtxWrite; ///< serializes writers and protects retired
+    std::vector<std::pair<unsigned long, const V*>> retired; ///< replaced values and the epoch they were retired in
+public:
+    RcuPointer(std::unique_ptr<V> initial);
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    RcuPointer(const RcuPointer&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    RcuPointer(RcuPointer&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    RcuPointer& operator=(RcuPointer&&) = delete;
+
+    virtual ~RcuPointer();
+
+    void update(std::unique_ptr<V> value);
+    void synchronize();
+    bool isReadByThisThread() const;
+
+private:
+    void reclaim_();
+};
+
+/**
+ * Enters a read section.
+ *
+ * @param rcu the RcuPointer to read
+ */
+template<typename V>
+inline RcuPointer<V>::ReadGuard::ReadGuard(RcuPointer& rcu) :
+        rcu(&rcu) {
+    while (true) {
+        unsigned long e = rcu.epoch.load();
+        slot = e & 1;
+        rcu.readers[slot].fetch_add(1);
+        if (rcu.epoch.load() == e) {
+            break;
+        }
+        // a writer advanced the epoch in between - register again
+        rcu.readers[slot].fetch_sub(1);
+    }
+    value = rcu.current.load();
+
+    section.owner = &rcu;
+    section.outer = innermostRcuReadSection();
+    innermostRcuReadSection() = &section;
+}
+
+/**
+ * Leaves the read section.
+ * Reclaims retired values if possible and no writer is busy.
+ */
+template<typename V>
+inline RcuPointer<V>::ReadGuard::~ReadGuard() {
+    innermostRcuReadSection() = section.outer;
+    rcu->readers[slot].fetch_sub(1, std::memory_order_release);
+
+    if (rcu->pendingRetired.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(rcu->mtxWrite, std::try_to_lock);
+        if (lock) {
+            rcu->reclaim_();
+        }
+    }
+}
+
+/**
+ * @return the value that was current when the read section was entered
+ */
+template<typename V>
+inline const V& RcuPointer<V>::ReadGuard::operator*() const {
+    return *value;
+}
+
+/**
+ * @return the value that was current when the read section was entered
+ */
+template<typename V>
+inline const V* RcuPointer<V>::ReadGuard::operator->() const {
+    return value;
+}
+
+/**
+ * Marks a read section on the current thread.
+ *
+ * @param rcu the RcuPointer that is read by another thread's ReadGuard
+ */
+template<typename V>
+inline RcuPointer<V>::ReadSectionMark::ReadSectionMark(const RcuPointer& rcu) {
+    section.owner = &rcu;
+    section.outer = innermostRcuReadSection();
+    innermostRcuReadSection() = &section;
+}
+
+/**
+ * Removes the mark.
+ */
+template<typename V>
+inline RcuPointer<V>::ReadSectionMark::~ReadSectionMark() {
+    innermostRcuReadSection() = section.outer;
+}
+
+/**
+ * Constructs a RcuPointer.
+ *
+ * @param initial the initial value
+ */
+template<typename V>
+inline RcuPointer<V>::RcuPointer(std::unique_ptr<V> initial) :
+        current(initial.release()), epoch(0), pendingRetired(false) {
+    readers[0] = 0;
+    readers[1] = 0;
+}
+
+/**
+ * Destructs a RcuPointer.
+ * @pre there must not be any readers left
+ */
+template<typename V>
+inline RcuPointer<V>::~RcuPointer() {
+    for (auto&& value : retired) {
+        delete value.second;
+    }
+    delete current.load();
+}
+
+/**
+ * Replaces the value.
+ * The old value is deleted once no reader can see it any more. Never waits
+ * for readers.
+ *
+ * @param value the new value
+ */
+template<typename V>
+inline void RcuPointer<V>::update(std::unique_ptr<V> value) {
+    std::lock_guard<std::mutex> lock(mtxWrite);
+    const V* old = current.exchange(value.release());
+    retired.emplace_back(epoch.load(), old);
+    pendingRetired = true;
+    reclaim_();
+}
+
+/**
+ * Waits until all replaced values are deleted, so no reader sees any of them
+ * any more.
+ * @attention calling this inside a read section of the same RcuPointer would
+ *            never return - check isReadByThisThread beforehand
+ */
+template<typename V>
+inline void RcuPointer<V>::synchronize() {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mtxWrite);
+            reclaim_();
+            if (retired.empty()) {
+                return;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @retval true the current thread is inside a read section of this RcuPointer
+ * @retval false the current thread is not reading
+ */
+template<typename V>
+inline bool RcuPointer<V>::isReadByThisThread() const {
+    for (auto section = innermostRcuReadSection(); section;
+            section = section->outer) {
+        if (section->owner == this) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Advances the epoch as far as possible and deletes all retired values that
+ * no reader can see any more.
+ * @pre caller must hold mtxWrite!
+ */
+template<typename V>
+inline void RcuPointer<V>::reclaim_() {
+    // Readers are only ever registered in the current or the previous epoch.
+    // Advancing to e + 1 requires all readers of e - 1 to be gone, as they
+    // share a counter with e + 1.
+    for (int i = 0; i < 2; ++i) {
+        unsigned long e = epoch.load();
+        if (readers[(e + 1) & 1].load(std::memory_order_acquire) != 0) {
+            break;
+        }
+        epoch.store(e + 1);
+    }
+
+    // a value retired in epoch r may still be seen by readers of epoch r, so
+    // it is safe to delete once the epoch reached r + 2
+    unsigned long e = epoch.load();
+    auto keep = retired.begin();
+    for (auto it = retired.begin(); it != retired.end(); ++it) {
+        if (it->first + 2 <= e) {
+            delete it->second;
+        } else {
+            *keep++ = *it;
+        }
+    }
+    retired.erase(keep, retired.end());
+    pendingRetired = !retired.empty();
+}
+
+} /* namespace broking */
+
+#endif /* BROKING_RCUPOINTER_H_ */
+/** @} */
@@ -0,0 +1,519 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_SPSCQUEUE_H_
+#define BROKING_SPSCQUEUE_H_
+
+#include "broking/AbstractQueueBase.h"
+#include "broking/LatencyHistogram.h"
+#include "util/optional.hpp"
+#include "util/util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <condition_variable>
+
+namespace broking {
+
+/**
+ * A bounded lock-free queue for exactly one producer and one consumer thread.
+ *
+ * The elements live in a ring of slots that is allocated once and constructed
+ * in place. Producer and consumer only share the two ring indices, which live
+ * on separate cache lines. The mutex is only used to park the consumer in a
+ * blocking dequeue on an empty queue.
+ *
+ * @attention enqueue operations must not be called concurrently, neither must
+ *            dequeue operations.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename T> class SPSCQueue: public AbstractQueueBase<T> {
+private:
+    /// uninitialized storage for one element
+    using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    std::size_t slotCount; ///< number of slots (one more than the maximum size)
+    std::unique_ptr<Slot[]> slots; ///< the ring of slots
+    std::shared_ptr<LatencyHistogram> dwellHistogram; ///< records how long messages stay queued - may be null
+    std::unique_ptr<LatencyHistogram::Stamp[]> stamps; ///< enqueue time per slot, if dwellHistogram is set - only written while it is enabled
+    std::mutex mtxWait; ///< protects parking of the consumer
+    std::condition_variable cvDequeue; ///< consumer waits on this if the queue is empty
+    std::function<void(void)> notifyCallback; ///< gets called by enqueue
+    WaitStrategy waitStrategy; ///< how the consumer waits for messages
+    char padShared[CACHE_LINE_SIZE]; ///< keeps the shared members above apart from head
+
+    // written by the consumer
+    std::atomic<std::size_t> head; ///< slot to dequeue from next
+    std::size_t cachedTail; ///< consumer's last known value of tail
+    std::atomic<bool> consumerWaiting; ///< set while the consumer is parked
+    char padHead[CACHE_LINE_SIZE]; ///< keeps head and tail on separate cache lines
+
+    // written by the producer
+    std::atomic<std::size_t> tail; ///< slot to enqueue into next
+    std::size_t cachedHead; ///< producer's last known value of head
+    char padTail[CACHE_LINE_SIZE]; ///< keeps tail apart from whatever follows
+public:
+    SPSCQueue(int size, std::shared_ptr<LatencyHistogram> dwellHistogram =
+            nullptr);
+
+    // prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    SPSCQueue(const SPSCQueue&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    SPSCQueue(SPSCQueue&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    SPSCQueue& operator=(SPSCQueue&&) = delete;
+
+    virtual ~SPSCQueue();
+
+    bool canEnqueue() override;
+    bool canDequeue() override;
+    std::size_t size() override;
+    std::size_t capacity() override;
+
+    bool tryEnqueue(T message) override;
+    template<typename ... Args> bool tryEmplace(Args&&... args);
+    bool enqueueUntil(T message, std::chrono::steady_clock::time_point deadline)
+            override;
+
+    std::experimental::optional<T> tryDequeue() override;
+    T dequeue() override;
+    std::experimental::optional<T> dequeueUntil(
+            std::chrono::steady_clock::time_point deadline) override;
+
+    std::size_t drain(const std::function<void(T&&)>& sink, std::size_t max)
+            override;
+    std::size_t drainUntil(const std::function<void(T&&)>& sink,
+            std::chrono::steady_clock::time_point deadline, std::size_t max)
+            override;
+
+    void setOnNewElement(std::function<void(void)> callback) override;
+    void unsetOnNewElement() override;
+
+    void setWaitStrategy(WaitStrategy strategy) override;
+
+private:
+    std::size_t next(std::size_t index) const;
+    T* element(std::size_t index);
+    bool spinForMessage_(std::chrono::steady_clock::time_point deadline);
+    void recordDwell(std::size_t index);
+};
+
+/**
+ * Constructs a SPSCQueue<T>.
+ *
+ * @param size the (maximum) size of the queue
+ * @param dwellHistogram records how long messages stay in the queue - optional
+ */
+template<typename T>
+inline SPSCQueue<T>::SPSCQueue(int size,
+        std::shared_ptr<LatencyHistogram> dwellHistogram) :
+        slotCount(size + 1), slots(new Slot[size + 1]), dwellHistogram(
+                std::move(dwellHistogram)), stamps(
+                this->dwellHistogram ?
+                        new LatencyHistogram::Stamp[size + 1] : nullptr), notifyCallback(
+                DO_NOTHING_CALLBACK), head(0), cachedTail(0), consumerWaiting(
+                false), tail(0), cachedHead(0) {
+}
+
+/**
+ * Destructs a SPSCQueue.
+ * Destroys all elements that are still queued.
+ */
+template<typename T>
+inline SPSCQueue<T>::~SPSCQueue() {
+    std::size_t end = tail.load(std::memory_order_relaxed);
+    for (std::size_t i = head.load(std::memory_order_relaxed); i != end; i =
+            next(i)) {
+        element(i)->~T();
+    }
+}
+
+/**
+ * Non-blocking enqueue.
+ *
+ * @param message the message to enqueue
+ * @retval true successfully enqueued
+ * @retval false unable to enqueue
+ */
+template<typename T>
+inline bool SPSCQueue<T>::tryEnqueue(T message) {
+    return tryEmplace(std::move(message));
+}
+
+/**
+ * Non-blocking enqueue that constructs the message in place.
+ *
+ * @param args the arguments to construct the message from
+ * @retval true successfully enqueued
+ * @retval false unable to enqueue
+ */
+template<typename T>
+template<typename ... Args>
+inline bool SPSCQueue<T>::tryEmplace(Args&&... args) {
+    std::size_t index = tail.load(std::memory_order_relaxed);
+    std::size_t nextIndex = next(index);
+    if (nextIndex == cachedHead) {
+        // looks full - check what the consumer did in the meantime
+        cachedHead = head.load(std::memory_order_acquire);
+        if (nextIndex == cachedHead) {
+            return false;
+        }
+    }
+
+    new (&slots[index]) T(std::forward<Args>(args)...);
+    if (stamps && dwellHistogram->isEnabled()) {
+        stamps[index] = dwellHistogram->stamp();
+    }
+    tail.store(nextIndex, std::memory_order_release);
+
+    notifyCallback();
+
+    // pairs with the fence in dequeue - either we see the consumer parking or
+    // the consumer sees the new tail
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumerWaiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mtxWait);
+        cvDequeue.notify_one();
+    }
+    return true;
+}
+
+/**
+ * Enqueue a message, waiting at most until a deadline for space.
+ * The consumer never wakes the producer, so this yields until there is space.
+ *
+ * @param message the message to enqueue
+ * @param deadline point in time to give up waiting
+ * @retval true successfully enqueued
+ * @retval false there was no space until the deadline
+ */
+template<typename T>
+inline bool SPSCQueue<T>::enqueueUntil(T message,
+        std::chrono::steady_clock::time_point deadline) {
+    // tryEmplace only moves from message if it succeeds
+    while (!tryEmplace(std::move(message))) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+/**
+ * Non-Blocking dequeue.
+ * @return the message wrapped in an optional, or an empty optional if there is
+ *         no message to dequeue
+ */
+template<typename T>
+inline std::experimental::optional<T> SPSCQueue<T>::tryDequeue() {
+    std::size_t index = head.load(std::memory_order_relaxed);
+    if (index == cachedTail) {
+        // looks empty - check what the producer did in the meantime
+        cachedTail = tail.load(std::memory_order_acquire);
+        if (index == cachedTail) {
+            return std::experimental::nullopt;
+        }
+    }
+
+    T* message = element(index);
+    std::experimental::optional<T> result(std::move(*message));
+    message->~T();
+    recordDwell(index);
+    head.store(next(index), std::memory_order_release);
+
+    return result;
+}
+
+/**
+ * Dequeue a message.
+ * @attention will BLOCK if there is no message to dequeue
+ *
+ * @return the message
+ */
+template<typename T>
+inline T SPSCQueue<T>::dequeue() {
+    while (true) {
+        auto message = tryDequeue();
+        if (message) {
+            return std::move(*message);
+        }
+        if (spinForMessage_(std::chrono::steady_clock::time_point::max())) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mtxWait);
+        consumerWaiting.store(true, std::memory_order_relaxed);
+        // pairs with the fence in tryEmplace
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (head.load(std::memory_order_relaxed)
+                == tail.load(std::memory_order_relaxed)) {
+            cvDequeue.wait(lock);
+        }
+        consumerWaiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Dequeue a message, waiting at most until a deadline.
+ *
+ * @param deadline point in time to give up waiting
+ * @return the message wrapped in an optional, or an empty optional if there
+ *         was no message until the deadline
+ */
+template<typename T>
+inline std::experimental::optional<T> SPSCQueue<T>::dequeueUntil(
+        std::chrono::steady_clock::time_point deadline) {
+    while (true) {
+        auto message = tryDequeue();
+        if (message || std::chrono::steady_clock::now() >= deadline) {
+            return message;
+        }
+        if (spinForMessage_(deadline)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mtxWait);
+        consumerWaiting.store(true, std::memory_order_relaxed);
+        // pairs with the fence in tryEmplace
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (head.load(std::memory_order_relaxed)
+                == tail.load(std::memory_order_relaxed)) {
+            cvDequeue.wait_until(lock, deadline);
+        }
+        consumerWaiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Non-blocking bulk dequeue.
+ * Moves all available messages (at most max) to sink and frees their slots
+ * with a single update of head.
+ * If sink throws, the message it got and all messages before are dequeued.
+ *
+ * @param sink gets called with each message, in FIFO order
+ * @param max the maximum number of messages to dequeue
+ * @return the number of dequeued messages
+ */
+template<typename T>
+inline std::size_t SPSCQueue<T>::drain(const std::function<void(T&&)>& sink,
+        std::size_t max) {
+    std::size_t index = head.load(std::memory_order_relaxed);
+    cachedTail = tail.load(std::memory_order_acquire);
+
+    std::size_t count = 0;
+    for (; count < max && index != cachedTail; ++count, index = next(index)) {
+        T* message = element(index);
+        try {
+            sink(std::move(*message));
+        } catch (...) {
+            // the destroyed messages must not stay in the queue
+            message->~T();
+            recordDwell(index);
+            head.store(next(index), std::memory_order_release);
+            throw;
+        }
+        message->~T();
+        recordDwell(index);
+    }
+
+    if (count > 0) {
+        head.store(index, std::memory_order_release);
+    }
+    return count;
+}
+
+/**
+ * Bulk dequeue that waits for the first message.
+ * Like drain, but blocks until there is at least one message or the deadline
+ * has passed.
+ *
+ * @param sink gets called with each message, in FIFO order
+ * @param deadline point in time to give up waiting
+ * @param max the maximum number of messages to dequeue
+ * @return the number of dequeued messages - 0 on timeout
+ */
+template<typename T>
+inline std::size_t SPSCQueue<T>::drainUntil(
+        const std::function<void(T&&)>& sink,
+        std::chrono::steady_clock::time_point deadline, std::size_t max) {
+    while (true) {
+        std::size_t count = drain(sink, max);
+        if (count > 0 || std::chrono::steady_clock::now() >= deadline) {
+            return count;
+        }
+        if (spinForMessage_(deadline)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mtxWait);
+        consumerWaiting.store(true, std::memory_order_relaxed);
+        // pairs with the fence in tryEmplace
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (head.load(std::memory_order_relaxed)
+                == tail.load(std::memory_order_relaxed)) {
+            cvDequeue.wait_until(lock, deadline);
+        }
+        consumerWaiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Changes the event callback for enqueueing new elements.
+ *
+ * @param callback the new callback
+ */
+template<typename T>
+inline void SPSCQueue<T>::setOnNewElement(std::function<void(void)> callback) {
+    notifyCallback = callback;
+}
+
+/**
+ * Removes the callback.
+ */
+template<typename T>
+inline void SPSCQueue<T>::unsetOnNewElement() {
+    notifyCallback = DO_NOTHING_CALLBACK;
+}
+
+/**
+ * Changes how the consumer waits for messages.
+ * @attention don't change it while the consumer is waiting
+ *
+ * @param strategy the new WaitStrategy
+ */
+template<typename T>
+inline void SPSCQueue<T>::setWaitStrategy(WaitStrategy strategy) {
+    waitStrategy = strategy;
+}
+
+/**
+ * Spins for a message according to the WaitStrategy, before the consumer
+ * parks.
+ *
+ * @param deadline point in time to give up waiting
+ * @retval true there is a message or the strategy doesn't park - try again
+ * @retval false the consumer has to park
+ */
+template<typename T>
+inline bool SPSCQueue<T>::spinForMessage_(
+        std::chrono::steady_clock::time_point deadline) {
+    return waitStrategy.spinUntil([this]() {
+        return canDequeue();
+    }, deadline) || !waitStrategy.parks();
+}
+
+/**
+ * Checks if there is a message to be dequeued
+ *
+ * @retval true there is a message to be dequeued
+ * @retval false there is no message to be dequeued
+ */
+template<typename T>
+inline bool SPSCQueue<T>::canDequeue() {
+    return head.load(std::memory_order_relaxed)
+            != tail.load(std::memory_order_acquire);
+}
+
+/**
+ * Checks if there is a space for a message
+ *
+ * @retval true there is space for a message to be queued
+ * @retval false there is no space for a message to be queued
+ */
+template<typename T>
+inline bool SPSCQueue<T>::canEnqueue() {
+    return next(tail.load(std::memory_order_relaxed))
+            != head.load(std::memory_order_acquire);
+}
+
+/**
+ * @return the number of queued messages - may be outdated as soon as it is
+ *         returned, unless called by the producer or the consumer
+ */
+template<typename T>
+inline std::size_t SPSCQueue<T>::size() {
+    std::size_t h = head.load(std::memory_order_acquire);
+    std::size_t t = tail.load(std::memory_order_acquire);
+    return t >= h ? t - h : t + slotCount - h;
+}
+
+/**
+ * @return the maximum number of queued messages
+ */
+template<typename T>
+inline std::size_t SPSCQueue<T>::capacity() {
+    return slotCount - 1;
+}
+
+/**
+ * @param index a slot index
+ * @return the index of the slot following index
+ */
+template<typename T>
+inline std::size_t SPSCQueue<T>::next(std::size_t index) const {
+    return index + 1 == slotCount ? 0 : index + 1;
+}
+
+/**
+ * @param index a slot index
+ * @return pointer to the element constructed in that slot
+ */
+template<typename T>
+inline T* SPSCQueue<T>::element(std::size_t index) {
+    return reinterpret_cast<T*>(&slots[index]);
+}
+
+/**
+ * Records the dwell time of the message that was dequeued from a slot.
+ * The Stamp of a slot isn't written without tracking, so it may be left over
+ * from an earlier message - the histogram ignores Stamps from before it was
+ * enabled.
+ *
+ * @param index a slot index
+ */
+template<typename T>
+inline void SPSCQueue<T>::recordDwell(std::size_t index) {
+    if (stamps && dwellHistogram->isEnabled()) {
+        dwellHistogram->recordSince(stamps[index]);
+    }
+}
+
+} /* namespace broking */
+
+#endif /* BROKING_SPSCQUEUE_H_ */
+/** @} */
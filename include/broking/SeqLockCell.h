@@ -0,0 +1,157 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_SEQLOCKCELL_H_
+#define BROKING_SEQLOCKCELL_H_
+
+#include "util/optional.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace broking {
+
+/**
+ * Holds the latest value of a trivially copyable type, protected by a
+ * sequence lock.
+ *
+ * Readers never write shared memory, so any number of them can read without
+ * slowing down writers or each other - they only retry if a write overlapped
+ * their read. The value is stored as atomic words, so a torn read is detected
+ * instead of being a data race.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename T> class SeqLockCell {
+private:
+    /// number of words the value is stored in
+    static constexpr std::size_t WORDS = (sizeof(T) + sizeof(std::uint64_t) - 1)
+            / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> sequence; ///< odd while a write is in progress, 0 before the first write
+    std::atomic<std::uint64_t> words[WORDS]; ///< the value
+public:
+    SeqLockCell();
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    SeqLockCell(const SeqLockCell&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    SeqLockCell(SeqLockCell&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    SeqLockCell& operator=(const SeqLockCell&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    SeqLockCell& operator=(SeqLockCell&&) = delete;
+
+    virtual ~SeqLockCell() = default;
+
+    void store(const T& value);
+    std::experimental::optional<T> load() const;
+};
+
+/**
+ * Constructs an empty SeqLockCell.
+ */
+template<typename T>
+inline SeqLockCell<T>::SeqLockCell() :
+        sequence(0) {
+    static_assert(std::is_trivially_copyable<T>::value,
+            "SeqLockCell requires a trivially copyable type");
+    for (auto&& word : words) {
+        word.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Replaces the value.
+ * Concurrent writers are serialized - each write only takes as long as
+ * copying the value.
+ *
+ * @param value the new value
+ */
+template<typename T>
+inline void SeqLockCell<T>::store(const T& value) {
+    std::uint64_t buffer[WORDS] = { };
+    std::memcpy(buffer, &value, sizeof(T));
+
+    // make the sequence odd - only one writer at a time succeeds
+    std::uint64_t seq = sequence.load(std::memory_order_relaxed);
+    while ((seq & 1) != 0
+            || !sequence.compare_exchange_weak(seq, seq + 1,
+                    std::memory_order_relaxed)) {
+        if ((seq & 1) != 0) {
+            std::this_thread::yield();
+            seq = sequence.load(std::memory_order_relaxed);
+        }
+    }
+    // keeps the words from being written before the sequence is odd
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (std::size_t i = 0; i < WORDS; ++i) {
+        words[i].store(buffer[i], std::memory_order_relaxed);
+    }
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+/**
+ * @return the latest value, or an empty optional if there never was one
+ */
+template<typename T>
+inline std::experimental::optional<T> SeqLockCell<T>::load() const {
+    std::uint64_t buffer[WORDS];
+    while (true) {
+        std::uint64_t seq = sequence.load(std::memory_order_acquire);
+        if (seq == 0) {
+            return std::experimental::nullopt;
+        }
+        if ((seq & 1) != 0) {
+            // a write is in progress
+            std::this_thread::yield();
+            continue;
+        }
+
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+        }
+        // keeps the words from being read after the sequence is checked
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == seq) {
+            break;
+        }
+    }
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type value;
+    std::memcpy(&value, buffer, sizeof(T));
+    return *reinterpret_cast<const T*>(&value);
+}
+
+} /* namespace broking */
+
+#endif /* BROKING_SEQLOCKCELL_H_ */
+/** @} */
@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_SHAREDPAYLOAD_H_
+#define BROKING_SHAREDPAYLOAD_H_
+
+#include <memory>
+#include <utility>
+
+namespace broking {
+
+/**
+ * Immutable, reference counted envelope for large messages.
+ *
+ * A Channel<SharedPayload<T>> wraps every message once when it is published.
+ * Passing it to a subscriber or storing it in a buffer only copies the
+ * pointer, so fan-out costs no copies of T regardless of the number of
+ * subscribers. It converts to const T&, so callbacks can take const T&.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename T> class SharedPayload {
+private:
+    std::shared_ptr<const T> payload; ///< the wrapped message
+public:
+    SharedPayload(T&& message);
+    SharedPayload(const T& message);
+    explicit SharedPayload(std::shared_ptr<const T> payload);
+
+    const T& get() const;
+    const T& operator*() const;
+    const T* operator->() const;
+    operator const T&() const;
+
+    std::shared_ptr<const T> getPointer() const;
+};
+
+/**
+ * Wraps a message by moving it into the envelope.
+ *
+ * @param message the message to wrap
+ */
+template<typename T>
+inline SharedPayload<T>::SharedPayload(T&& message) :
+        payload(std::make_shared<const T>(std::move(message))) {
+}
+
+/**
+ * Wraps a copy of a message.
+ *
+ * @param message the message to wrap
+ */
+template<typename T>
+inline SharedPayload<T>::SharedPayload(const T& message) :
+        payload(std::make_shared<const T>(message)) {
+}
+
+/**
+ * Wraps a message that is already shared.
+ *
+ * @param payload pointer to the message
+ */
+template<typename T>
+inline SharedPayload<T>::SharedPayload(std::shared_ptr<const T> payload) :
+        payload(std::move(payload)) {
+}
+
+/**
+ * @return the wrapped message
+ */
+template<typename T>
+inline const T& SharedPayload<T>::get() const {
+    return *payload;
+}
+
+/**
+ * @return the wrapped message
+ */
+template<typename T>
+inline const T& SharedPayload<T>::operator*() const {
+    return *payload;
+}
+
+/**
+ * @return pointer to the wrapped message
+ */
+template<typename T>
+inline const T* SharedPayload<T>::operator->() const {
+    return payload.get();
+}
+
+/**
+ * @return the wrapped message
+ */
+template<typename T>
+inline SharedPayload<T>::operator const T&() const {
+    return *payload;
+}
+
+/**
+ * @return the pointer shared by all copies of this envelope
+ */
+template<typename T>
+inline std::shared_ptr<const T> SharedPayload<T>::getPointer() const {
+    return payload;
+}
+
+} /* namespace broking */
+
+#endif /* BROKING_SHAREDPAYLOAD_H_ */
+/** @} */
@@ -14,11 +14,18 @@
 #ifndef BROKING_THREADSAFEQUEUE_H_
 #define BROKING_THREADSAFEQUEUE_H_
 
+#include "broking/AbstractQueueBase.h"
+#include "broking/LatencyHistogram.h"
 #include "util/optional.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <functional>
+#include <utility>
 #include <condition_variable>
 
 namespace broking {
@@ -29,16 +36,23 @@ namespace broking {
  * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
  * @version 1.0
  */
-template<typename T> class ThreadSafeQueue {
+template<typename T> class ThreadSafeQueue: public AbstractQueueBase<T> {
 private:
     std::mutex mtxAccess; ///< protects access to the queue
     std::condition_variable cvDequeue; ///< condition variable for dequeue
     std::condition_variable cvEnqueue; ///< condition variable for enqueue
     std::deque<T> queue; ///< the underlying STL container representing the queue
     int maxSize; ///< maximum size of the queue
+    int dequeueWaiters; ///< number of consumers parked on cvDequeue
+    int enqueueWaiters; ///< number of producers parked on cvEnqueue
     std::function<void(void)> notifyCallback; ///< gets called by enqueue
+    std::shared_ptr<LatencyHistogram> dwellHistogram; ///< records how long messages stay queued - may be null
+    std::deque<LatencyHistogram::Stamp> stamps; ///< enqueue time of each message while dwellHistogram is enabled - empty or one per message
+    WaitStrategy waitStrategy; ///< how consumers wait for messages
+    std::atomic<std::size_t> length; ///< number of queued messages, for consumers that spin without the lock
 public:
-    ThreadSafeQueue(int size);
+    ThreadSafeQueue(int size, std::shared_ptr<LatencyHistogram> dwellHistogram =
+            nullptr);
 
     // prevent moving and copying
     /**
@@ -61,37 +75,62 @@ public:
      */
     ThreadSafeQueue& operator=(ThreadSafeQueue&&) = delete;
 
-    bool canEnqueue();
-    bool canDequeue();
+    bool canEnqueue() override;
+    bool canDequeue() override;
+    std::size_t size() override;
+    std::size_t capacity() override;
 
-    bool tryEnqueue(T message);
+    bool tryEnqueue(T message) override;
     void enqueue(T message);
+    bool enqueueUntil(T message, std::chrono::steady_clock::time_point deadline)
+            override;
+    bool enqueueDroppingOldest(T message);
+    bool enqueueConflating(T message,
+            const std::function<bool(const T&, const T&)>& sameKey);
 
-    std::experimental::optional<T> tryDequeue();
-    T dequeue();
+    std::experimental::optional<T> tryDequeue() override;
+    T dequeue() override;
+    std::experimental::optional<T> dequeueUntil(
+            std::chrono::steady_clock::time_point deadline) override;
 
-    void setOnNewElement(std::function<void(void)> callback);
-    void unsetOnNewElement();
+    std::size_t drain(const std::function<void(T&&)>& sink, std::size_t max)
+            override;
+    std::size_t drainUntil(const std::function<void(T&&)>& sink,
+            std::chrono::steady_clock::time_point deadline, std::size_t max)
+            override;
+
+    void setOnNewElement(std::function<void(void)> callback) override;
+    void unsetOnNewElement() override;
+
+    void setWaitStrategy(WaitStrategy strategy) override;
 
 private:
     bool canEnqueue_();
     bool canDequeue_();
+    bool waitForMessage_(std::unique_lock<std::mutex>& lock,
+            std::chrono::steady_clock::time_point deadline);
 
     void enqueue_(T message);
     T dequeue_();
+    void dropOldest_();
+    void pushStamp_();
+    void popStamp_();
+    std::size_t drain_(const std::function<void(T&&)>& sink, std::size_t max);
+    void drained_(std::size_t count);
 
 };
 
-static auto DO_NOTHING_CALLBACK = [](){};
-
 /**
  * Constructs a ThreadSafeQueue<T>.
  *
  * @param size the (maximum) size of the queue
+ * @param dwellHistogram records how long messages stay in the queue - optional
  */
 template<typename T>
-inline ThreadSafeQueue<T>::ThreadSafeQueue(int size) :
-        maxSize(size), notifyCallback(DO_NOTHING_CALLBACK) {
+inline ThreadSafeQueue<T>::ThreadSafeQueue(int size,
+        std::shared_ptr<LatencyHistogram> dwellHistogram) :
+        maxSize(size), dequeueWaiters(0), enqueueWaiters(0), notifyCallback(DO_NOTHING_CALLBACK), dwellHistogram(
+                std::move(dwellHistogram)), length(0) {
 }
 
 /**
@@ -105,7 +144,7 @@ template<typename T>
 inline bool ThreadSafeQueue<T>::tryEnqueue(T message) {
     std::lock_guard<std::mutex> lock(mtxAccess);
     if (canEnqueue_()) {
-        enqueue_(message);
+        enqueue_(std::move(message));
         return true;
     } else {
         return false;
@@ -122,21 +161,112 @@ template<typename T>
 inline void ThreadSafeQueue<T>::enqueue(T message) {
     std::unique_lock<std::mutex> lock(mtxAccess);
     while (!canEnqueue_()) {
+        ++enqueueWaiters;
         cvEnqueue.wait(lock);
+        --enqueueWaiters;
+    }
+    enqueue_(std::move(message));
+}
+
+/**
+ * Enqueue a message, waiting at most until a deadline for space.
+ *
+ * @param message the message to enqueue
+ * @param deadline point in time to give up waiting
+ * @retval true successfully enqueued
+ * @retval false there was no space until the deadline
+ */
+template<typename T>
+inline bool ThreadSafeQueue<T>::enqueueUntil(T message,
+        std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mtxAccess);
+    while (!canEnqueue_()) {
+        ++enqueueWaiters;
+        bool timeout = cvEnqueue.wait_until(lock, deadline)
+                == std::cv_status::timeout;
+        --enqueueWaiters;
+        if (timeout) {
+            break;
+        }
+    }
+
+    if (!canEnqueue_()) {
+        return false;
+    }
+    enqueue_(std::move(message));
+    return true;
+}
+
+/**
+ * Enqueue a message, dropping the oldest message if there is no space.
+ *
+ * @param message the message to enqueue
+ * @retval true a message was dropped
+ * @retval false there was space
+ */
+template<typename T>
+inline bool ThreadSafeQueue<T>::enqueueDroppingOldest(T message) {
+    std::lock_guard<std::mutex> lock(mtxAccess);
+    bool dropped = false;
+    if (!canEnqueue_() && !queue.empty()) {
+        dropOldest_();
+        dropped = true;
+    }
+    enqueue_(std::move(message));
+    return dropped;
+}
+
+/**
+ * Enqueue a message, replacing a queued message with the same key.
+ * The replaced message keeps its position. If there is none and no space, the
+ * oldest message is dropped.
+ *
+ * @param message the message to enqueue
+ * @param sameKey returns true if two messages have the same key
+ * @retval true a message was replaced or dropped
+ * @retval false the message was appended to the queue
+ */
+template<typename T>
+inline bool ThreadSafeQueue<T>::enqueueConflating(T message,
+        const std::function<bool(const T&, const T&)>& sameKey) {
+    std::lock_guard<std::mutex> lock(mtxAccess);
+    for (std::size_t i = 0; i < queue.size(); ++i) {
+        if (sameKey(queue[i], message)) {
+            queue[i] = std::move(message);
+            if (dwellHistogram && dwellHistogram->isEnabled()) {
+                stamps.resize(queue.size());
+                stamps[i] = dwellHistogram->stamp();
+            } else if (!stamps.empty()) {
+                stamps[i] = LatencyHistogram::Stamp();
+            }
+            return true;
+        }
     }
-    enqueue_(message);
+
+    bool dropped = false;
+    if (!canEnqueue_() && !queue.empty()) {
+        dropOldest_();
+        dropped = true;
+    }
+    enqueue_(std::move(message));
+    return dropped;
 }
 
 /**
  * Internal implementation of enqueue.
  * @pre caller must hold mtxAccess!
- * @param message
+ * @param message the message to enqueue
  */
 template<typename T>
 inline void ThreadSafeQueue<T>::enqueue_(T message) {
-    queue.push_back(message);
+    queue.push_back(std::move(message));
+    pushStamp_();
+    length.store(queue.size(), std::memory_order_release);
     notifyCallback();
-    cvDequeue.notify_one();
+    // waiters register under the lock, so nobody can be about to park
+    if (dequeueWaiters > 0) {
+        cvDequeue.notify_one();
+    }
 }
 
 /**
@@ -164,11 +294,74 @@ template<typename T>
 inline T ThreadSafeQueue<T>::dequeue() {
     std::unique_lock<std::mutex> lock(mtxAccess);
     while (!canDequeue_()) {
-        cvDequeue.wait(lock);
+        waitForMessage_(lock, std::chrono::steady_clock::time_point::max());
     }
     return dequeue_();
 }
 
+/**
+ * Dequeue a message, waiting at most until a deadline.
+ *
+ * @param deadline point in time to give up waiting
+ * @return the message wrapped in an optional, or an empty optional if there
+ *         was no message until the deadline
+ */
+template<typename T>
+inline std::experimental::optional<T> ThreadSafeQueue<T>::dequeueUntil(
+        std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mtxAccess);
+    while (!canDequeue_()) {
+        if (!waitForMessage_(lock, deadline)) {
+            break;
+        }
+    }
+
+    if (canDequeue_()) {
+        return {dequeue_()};
+    } else {
+        return std::experimental::nullopt;
+    }
+}
+
+/**
+ * Non-blocking bulk dequeue.
+ * Moves all available messages (at most max) to sink while holding the lock
+ * only once.
+ *
+ * @param sink gets called with each message, in FIFO order
+ * @param max the maximum number of messages to dequeue
+ * @return the number of dequeued messages
+ */
+template<typename T>
+inline std::size_t ThreadSafeQueue<T>::drain(
+        const std::function<void(T&&)>& sink, std::size_t max) {
+    std::lock_guard<std::mutex> lock(mtxAccess);
+    return drain_(sink, max);
+}
+
+/**
+ * Bulk dequeue that waits for the first message.
+ * Like drain, but blocks until there is at least one message or the deadline
+ * has passed.
+ *
+ * @param sink gets called with each message, in FIFO order
+ * @param deadline point in time to give up waiting
+ * @param max the maximum number of messages to dequeue
+ * @return the number of dequeued messages - 0 on timeout
+ */
+template<typename T>
+inline std::size_t ThreadSafeQueue<T>::drainUntil(
+        const std::function<void(T&&)>& sink,
+        std::chrono::steady_clock::time_point deadline, std::size_t max) {
+    std::unique_lock<std::mutex> lock(mtxAccess);
+    while (!canDequeue_()) {
+        if (!waitForMessage_(lock, deadline)) {
+            break;
+        }
+    }
+    return drain_(sink, max);
+}
+
 /**
  * Changes the event callback for enqueueing new elements.
  *
@@ -188,6 +381,63 @@ inline void ThreadSafeQueue<T>::unsetOnNewElement() {
 	notifyCallback = DO_NOTHING_CALLBACK;
 }
 
+/**
+ * Changes how consumers wait for messages.
+ * @attention don't change it while a consumer is waiting
+ *
+ * @param strategy the new WaitStrategy
+ */
+template<typename T>
+inline void ThreadSafeQueue<T>::setWaitStrategy(WaitStrategy strategy) {
+    std::lock_guard<std::mutex> lock(mtxAccess);
+    waitStrategy = strategy;
+}
+
+/**
+ * Waits for a message according to the WaitStrategy: spins without holding
+ * the lock, then parks on cvDequeue if the strategy allows it.
+ * May return before there is a message - the caller has to check again.
+ * @pre caller must hold lock on mtxAccess!
+ *
+ * @param lock the lock on mtxAccess
+ * @param deadline point in time to give up waiting
+ * @retval true there might be a message
+ * @retval false the deadline has passed
+ */
+template<typename T>
+inline bool ThreadSafeQueue<T>::waitForMessage_(
+        std::unique_lock<std::mutex>& lock,
+        std::chrono::steady_clock::time_point deadline) {
+    if (waitStrategy.kind != WaitKind::BLOCK) {
+        WaitStrategy strategy = waitStrategy;
+        lock.unlock();
+        bool ready = strategy.spinUntil([this]() {
+            return length.load(std::memory_order_acquire) > 0;
+        }, deadline);
+        lock.lock();
+
+        if (ready || canDequeue_()) {
+            return true;
+        }
+        if (!strategy.parks()) {
+            return false;
+        }
+    }
+
+    // producers notify while holding the lock, so checking canDequeue_ before
+    // waiting can't miss a message
+    ++dequeueWaiters;
+    bool signalled = true;
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+        cvDequeue.wait(lock);
+    } else {
+        signalled = cvDequeue.wait_until(lock, deadline)
+                == std::cv_status::no_timeout;
+    }
+    --dequeueWaiters;
+    return signalled;
+}
+
 /**
  * Internal implementation of dequeue.
  * @pre caller must hold mtxAccess!
@@ -195,13 +445,106 @@ inline void ThreadSafeQueue<T>::unsetOnNewElement() {
  */
 template<typename T>
 inline T ThreadSafeQueue<T>::dequeue_() {
-    auto result = queue.front();
+    T result = std::move(queue.front());
     queue.pop_front();
-    cvEnqueue.notify_one();
+    popStamp_();
+    length.store(queue.size(), std::memory_order_relaxed);
+    if (enqueueWaiters > 0) {
+        cvEnqueue.notify_one();
+    }
 
     return result;
 }
 
+/**
+ * Internal implementation of drain.
+ * If sink throws, the message it got and all messages before are dequeued.
+ * @pre caller must hold mtxAccess!
+ *
+ * @param sink gets called with each message, in FIFO order
+ * @param max the maximum number of messages to dequeue
+ * @return the number of dequeued messages
+ */
+template<typename T>
+inline std::size_t ThreadSafeQueue<T>::drain_(
+        const std::function<void(T&&)>& sink, std::size_t max) {
+    std::size_t count = 0;
+    while (count < max && canDequeue_()) {
+        try {
+            sink(std::move(queue.front()));
+        } catch (...) {
+            // the moved-from message must not stay in the queue
+            queue.pop_front();
+            popStamp_();
+            drained_(count + 1);
+            throw;
+        }
+        queue.pop_front();
+        popStamp_();
+        ++count;
+    }
+    drained_(count);
+    return count;
+}
+
+/**
+ * Updates the length and wakes blocked producers after a drain.
+ * @pre caller must hold mtxAccess!
+ *
+ * @param count the number of dequeued messages
+ */
+template<typename T>
+inline void ThreadSafeQueue<T>::drained_(std::size_t count) {
+    length.store(queue.size(), std::memory_order_relaxed);
+
+    if (count > 0 && enqueueWaiters > 0) {
+        // there might be more than one blocked producer now
+        cvEnqueue.notify_all();
+    }
+}
+
+/**
+ * Removes the oldest message without recording its dwell time.
+ * @pre caller must hold mtxAccess and the queue must not be empty!
+ */
+template<typename T>
+inline void ThreadSafeQueue<T>::dropOldest_() {
+    queue.pop_front();
+    if (!stamps.empty()) {
+        stamps.pop_front();
+    }
+    length.store(queue.size(), std::memory_order_relaxed);
+}
+
+/**
+ * Stamps the message that was enqueued last.
+ * Without tracking, stamps stays empty - once the messages stamped before
+ * tracking was disabled are dequeued.
+ * @pre caller must hold mtxAccess!
+ */
+template<typename T>
+inline void ThreadSafeQueue<T>::pushStamp_() {
+    if (dwellHistogram && dwellHistogram->isEnabled()) {
+        // messages enqueued without tracking get Stamps that aren't recorded
+        stamps.resize(queue.size() - 1);
+        stamps.push_back(dwellHistogram->stamp());
+    } else if (!stamps.empty()) {
+        stamps.push_back(LatencyHistogram::Stamp());
+    }
+}
+
+/**
+ * Records the dwell time of the message that was dequeued last.
+ * @pre caller must hold mtxAccess!
+ */
+template<typename T>
+inline void ThreadSafeQueue<T>::popStamp_() {
+    if (!stamps.empty()) {
+        dwellHistogram->recordSince(stamps.front());
+        stamps.pop_front();
+    }
+}
+
 /**
  * Checks if there is a message to be dequeued
  *
@@ -226,6 +569,23 @@ inline bool ThreadSafeQueue<T>::canDequeue_() {
     return !queue.empty();
 }
 
+/**
+ * @return the number of queued messages
+ */
+template<typename T>
+inline std::size_t ThreadSafeQueue<T>::size() {
+    std::lock_guard<std::mutex> lock(mtxAccess);
+    return queue.size();
+}
+
+/**
+ * @return the maximum number of queued messages
+ */
+template<typename T>
+inline std::size_t ThreadSafeQueue<T>::capacity() {
+    return maxSize;
+}
+
 /**
  * Checks if there is a space for a message
  *
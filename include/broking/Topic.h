@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_TOPIC_H_
+#define BROKING_TOPIC_H_
+
+#include <cstdint>
+
+namespace broking {
+
+/**
+ * FNV-1a hash of a channel name, computed at compile time for literals.
+ *
+ * @param name the name to hash
+ * @param hash hash of the characters before name - leave at default
+ * @return the 64 bit hash of name
+ */
+constexpr std::uint64_t hashTopicName(const char* name,
+        std::uint64_t hash = 14695981039346656037ull) {
+    return *name == '\0' ?
+            hash :
+            hashTopicName(name + 1,
+                    (hash ^ static_cast<unsigned char>(*name))
+                            * 1099511628211ull);
+}
+
+/**
+ * Compile time descriptor that binds a channel name to its type.
+ * Create it with the TOPIC macro and resolve it with
+ * Broker::getChannel(const Topic<T, Hash>&) or GET_TOPIC.
+ *
+ * @tparam T the type of the channel
+ * @tparam Hash hashTopicName of the channel name
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename T, std::uint64_t Hash> struct Topic {
+    using type = T; ///< the type of the channel
+    static constexpr std::uint64_t hash = Hash; ///< hash of the channel name
+    const char* name; ///< the name of the channel
+};
+
+/**
+ * Definition of Topic<T, Hash>::hash
+ */
+template<typename T, std::uint64_t Hash>
+constexpr std::uint64_t Topic<T, Hash>::hash;
+
+} /* namespace broking */
+
+/**
+ * Creates a constexpr Topic for a channel with type and ID.
+ * The ID must be a string literal.
+ */
+#define TOPIC(type, id) \
+    broking::Topic<type, broking::hashTopicName(id)>{id}
+
+#endif /* BROKING_TOPIC_H_ */
+/** @} */
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_TOPICTRIE_H_
+#define BROKING_TOPICTRIE_H_
+
+#include "broking/ChannelRegistry.h"
+
+#include <functional>
+#include <typeindex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace broking {
+
+/**
+ * Index of channel names and wildcard patterns by their dot separated levels.
+ *
+ * In a pattern, `*` matches exactly one level and `#` (only as the last
+ * level) any number of levels, including none - so `sensors.#` matches
+ * `sensors`, `sensors.temperature` and `sensors.temperature.kitchen`.
+ *
+ * Channels and patterns share a tree with one node per level. Matching a new
+ * channel against the patterns only follows its own levels and the wildcard
+ * branches on the way, and matching a new pattern against the channels only
+ * visits the part of the tree the pattern covers - neither depends on the
+ * total number of channels. Every pair of a channel and a matching pattern is
+ * attached exactly once, no matter which one was added first.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class TopicTrie {
+public:
+    /**
+     * A channel in the tree
+     */
+    struct ChannelInfo {
+        std::string name; ///< the name of the channel
+        std::type_index type; ///< the type of the channel's messages
+        AbstractChannelBase* channel; ///< the channel
+    };
+
+    /// attaches the subscriber of a pattern to a matching channel
+    using Attach = std::function<void(const ChannelInfo&)>;
+
+private:
+    /**
+     * A level in the tree
+     */
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>> children; ///< next levels by name
+        std::unique_ptr<ChannelInfo> channel; ///< the channel with this name, if there is one
+        std::map<int, Attach> patterns; ///< the patterns that end here, by ID
+    };
+
+    std::mutex mtxTrie; ///< protects all members below
+    Node root; ///< the level above the first level
+    int nextPatternID; ///< ID of the next pattern
+public:
+    TopicTrie();
+
+    // Prevent moving and copying
+    /**
+     * Delete Copy-Constructor
+     */
+    TopicTrie(const TopicTrie&) = delete;
+
+    /**
+     * Delete Move-Constructor
+     */
+    TopicTrie(TopicTrie&&) = delete;
+
+    /**
+     * Delete Copy-Assignment
+     */
+    TopicTrie& operator=(const TopicTrie&) = delete;
+
+    /**
+     * Delete Move-Assignment
+     */
+    TopicTrie& operator=(TopicTrie&&) = delete;
+
+    void addChannel(const std::string& name, std::type_index type,
+            AbstractChannelBase& channel);
+    int addPattern(const std::string& pattern, Attach attach);
+    void removePattern(const std::string& pattern, int id);
+
+    static std::vector<std::string> split(const std::string& name);
+
+private:
+    Node& insert_(const std::vector<std::string>& levels);
+    static void matchPatterns_(Node& node,
+            const std::vector<std::string>& levels, std::size_t index,
+            const ChannelInfo& info);
+    static void matchChannels_(Node& node,
+            const std::vector<std::string>& levels, std::size_t index,
+            const Attach& attach);
+    static void attachSubtree_(Node& node, const Attach& attach);
+    static void attach_(const Attach& attach, const ChannelInfo& info);
+};
+
+} /* namespace broking */
+
+#endif /* BROKING_TOPICTRIE_H_ */
+/** @} */
@@ -0,0 +1,126 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_WAITSTRATEGY_H_
+#define BROKING_WAITSTRATEGY_H_
+
+#include <chrono>
+#include <thread>
+
+namespace broking {
+
+/**
+ * Default number of checks before a spinning thread yields or parks
+ */
+constexpr unsigned DEFAULT_SPIN_BUDGET = 1000;
+
+/**
+ * How a thread waits for a queue or a task
+ */
+enum class WaitKind {
+    BLOCK, ///< park right away - no CPU is used while waiting
+    SPIN, ///< busy-spin, never park - burns a whole core
+    SPIN_YIELD, ///< busy-spin, then yield the CPU between checks - never park
+    SPIN_PARK ///< busy-spin, then park
+};
+
+/**
+ * Tells the CPU that the current thread is busy-waiting.
+ */
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * Describes how a thread waits - the spinning kinds trade CPU time for a
+ * faster wakeup, as they don't need to be woken by the kernel.
+ *
+ * A WaitKind converts implicitly, pass a spin budget for the other kinds.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+struct WaitStrategy {
+    WaitKind kind; ///< how to wait
+    unsigned spins; ///< checks before yielding or parking
+
+    /**
+     * Constructs a WaitStrategy.
+     *
+     * @param kind how to wait
+     * @param spins number of checks before WaitKind::SPIN_YIELD yields and
+     *              WaitKind::SPIN_PARK parks
+     */
+    WaitStrategy(WaitKind kind = WaitKind::BLOCK, unsigned spins =
+            DEFAULT_SPIN_BUDGET) :
+            kind(kind), spins(spins) {
+    }
+
+    /**
+     * @retval true the waiting thread parks after spinUntil gave up
+     * @retval false spinUntil only gives up at the deadline
+     */
+    bool parks() const {
+        return kind == WaitKind::BLOCK || kind == WaitKind::SPIN_PARK;
+    }
+
+    /**
+     * Busy-waits for a condition, as far as the strategy allows.
+     * Doesn't wait at all for WaitKind::BLOCK, and only up to the spin budget
+     * for WaitKind::SPIN_PARK - the caller then parks if the condition is
+     * still false.
+     *
+     * @param ready returns true once the wait is over - must not block
+     * @param deadline point in time to give up waiting
+     * @retval true ready returned true
+     * @retval false the strategy or the deadline ended the wait first
+     */
+    template<typename Ready>
+    bool spinUntil(Ready ready, std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::time_point::max()) const {
+        bool timed = deadline != std::chrono::steady_clock::time_point::max();
+        if (kind == WaitKind::BLOCK) {
+            return ready();
+        }
+
+        for (unsigned i = 0; kind == WaitKind::SPIN || i < spins; ++i) {
+            if (ready()) {
+                return true;
+            }
+            if (timed && std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            cpuRelax();
+        }
+
+        if (kind == WaitKind::SPIN_YIELD) {
+            while (!ready()) {
+                if (timed && std::chrono::steady_clock::now() >= deadline) {
+                    return false;
+                }
+                std::this_thread::yield();
+            }
+            return true;
+        }
+        return ready();
+    }
+};
+
+} /* namespace broking */
+
+#endif /* BROKING_WAITSTRATEGY_H_ */
+/** @} */
@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#ifndef BROKING_WILDCARDSUBSCRIPTION_H_
+#define BROKING_WILDCARDSUBSCRIPTION_H_
+
+#include "broking/Subscription.h"
+#include "broking/TopicTrie.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace broking {
+
+/**
+ * Represents a subscription to all channels that match a pattern, see
+ * Broker::subscribePattern.
+ * Unsubscribes from all of them when it is destroyed.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class WildcardSubscription {
+public:
+    /**
+     * The subscriptions to the matching channels, shared with the trie.
+     */
+    struct Channels {
+        std::vector<Subscription> subscriptions; ///< one per matching channel - only changed while the trie is locked
+        std::atomic<std::size_t> count; ///< size of subscriptions, readable without the lock
+
+        /**
+         * Constructs an empty Channels.
+         */
+        Channels() :
+                count(0) {
+        }
+    };
+
+private:
+    TopicTrie* topics; ///< the trie the pattern is registered in
+    std::string pattern; ///< the pattern
+    int id; ///< ID of the pattern in the trie
+    std::shared_ptr<Channels> channels; ///< the subscriptions to the matching channels
+public:
+    WildcardSubscription();
+    WildcardSubscription(TopicTrie& topics, std::string pattern, int id,
+            std::shared_ptr<Channels> channels);
+
+    // Class is move only
+    /**
+     * Delete Copy Constructor
+     */
+    WildcardSubscription(const WildcardSubscription&) = delete;
+
+    /**
+     * Delete Copy assignment
+     */
+    WildcardSubscription& operator=(const WildcardSubscription&) = delete;
+
+    WildcardSubscription(WildcardSubscription&& other);
+    WildcardSubscription& operator=(WildcardSubscription&& other);
+
+    virtual ~WildcardSubscription();
+
+    const std::string& getPattern() const;
+    std::size_t getChannelCount() const;
+
+    void unsubscribe();
+};
+
+} /* namespace broking */
+
+#endif /* BROKING_WILDCARDSUBSCRIPTION_H_ */
+/** @} */
@@ -15,16 +15,32 @@
 #define BROKING_BROKING_H_
 
 #include "broking/Broker.h"
+#include "broking/PartitionedChannel.h"
+#include "broking/SharedPayload.h"
 
 using namespace broking;
 
 /**
  * Shortcut to getting a channel with type and ID.
- * Refer to Broker::getChannel<T>(std::string id) for details.
+ * Refer to Broker::getChannel<T>(const std::string& id) for details.
  */
 #define GET_CHANNEL(type, id) \
     Broker::getBroker().getChannel<type>(id)
 
+/**
+ * Shortcut to getting the channel of a Topic created with TOPIC(type, id).
+ * Refer to Broker::getChannel(const Topic<T, Hash>&) for details.
+ */
+#define GET_TOPIC(topic) \
+    Broker::getBroker().getChannel(topic)
+
+/**
+ * Shortcut to subscribing to all channels that match a pattern.
+ * Refer to Broker::subscribePattern<T>(const std::string&, ...) for details.
+ */
+#define SUBSCRIBE_PATTERN(type, pattern, callback) \
+    Broker::getBroker().subscribePattern<type>(pattern, callback)
+
 
 #endif /* INCLUDE_BROKING_BROKING_H_ */
 /** @} */
@@ -15,8 +15,14 @@
 #ifndef UTIL_UTIL_H_
 #define UTIL_UTIL_H_
 
+#include <cstddef>
 #include <thread>
 
+/**
+ * Assumed size of a cache line, used to keep independently written data apart
+ */
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
 /**
  * Sleeps on the current thread
  */
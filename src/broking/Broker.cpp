@@ -30,6 +30,57 @@ Broker& Broker::getBroker() {
     return instance;
 }
 
+/**
+ * @return the Executor that processes the messages of all channels
+ */
+Executor& Broker::getExecutor() {
+    return executor;
+}
+
+/**
+ * Enables or disables tracking of latencies on all existing channels.
+ * Channels created afterwards have to be enabled separately.
+ *
+ * @param enable true to track latencies
+ */
+void Broker::setLatencyTracking(bool enable) {
+    channels.forEach([enable](ChannelRegistry::Entry& entry) {
+        entry.channel->setLatencyTracking(enable);
+    });
+}
+
+/**
+ * @return snapshots of the latencies of all channels
+ */
+std::vector<ChannelLatency> Broker::getLatencies() {
+    std::vector<ChannelLatency> latencies;
+    channels.forEach([&latencies](ChannelRegistry::Entry& entry) {
+        latencies.push_back(entry.channel->getLatency());
+    });
+    return latencies;
+}
+
+/**
+ * @return the statistics of all channels
+ */
+std::vector<ChannelStats> Broker::getStats() {
+    std::vector<ChannelStats> stats;
+    channels.forEach([&stats](ChannelRegistry::Entry& entry) {
+        stats.push_back(entry.channel->getStats());
+    });
+    return stats;
+}
+
+/**
+ * Executor used by channels that are not explicitly given one.
+ * Belongs to the Broker, so it outlives all channels created by it.
+ *
+ * @return the Broker's Executor
+ */
+Executor& getSharedExecutor() {
+    return Broker::getBroker().getExecutor();
+}
+
 /**
  * Kinda hacky "singleton" - creates the WARNING_CHANNEL for infrormation about
  * non critical messages (Severity::WARNING) that are dropped.
@@ -0,0 +1,124 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#include "broking/ChannelRegistry.h"
+
+namespace broking {
+
+/**
+ * Constructs an empty ChannelRegistry.
+ */
+ChannelRegistry::ChannelRegistry() {
+    for (auto&& bucket : buckets) {
+        bucket.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Destructs a ChannelRegistry and all channels in it.
+ */
+ChannelRegistry::~ChannelRegistry() {
+    for (auto&& bucket : buckets) {
+        Entry* entry = bucket.load(std::memory_order_relaxed);
+        while (entry) {
+            Entry* next = entry->next;
+            delete entry;
+            entry = next;
+        }
+    }
+}
+
+/**
+ * Lock-free lookup of a channel.
+ *
+ * @param name the name of the channel
+ * @return the Entry of the channel, or nullptr if there is none
+ */
+ChannelRegistry::Entry* ChannelRegistry::find(const std::string& name) {
+    std::size_t hash = std::hash<std::string>()(name);
+    return findInBucket(
+            buckets[hash % CHANNEL_REGISTRY_BUCKETS].load(
+                    std::memory_order_acquire), name, hash);
+}
+
+/**
+ * Lookup of a channel that creates it, if it doesn't exist yet.
+ * Only takes a lock if the channel has to be created.
+ *
+ * @param name the name of the channel
+ * @param type the type of the channel's messages, if it is created
+ * @param create creates the channel - called at most once
+ * @return the Entry of the channel
+ */
+ChannelRegistry::Entry& ChannelRegistry::findOrCreate(const std::string& name,
+        std::type_index type,
+        const std::function<AbstractChannelBase*(void)>& create) {
+    std::size_t hash = std::hash<std::string>()(name);
+    std::size_t index = hash % CHANNEL_REGISTRY_BUCKETS;
+
+    Entry* head = buckets[index].load(std::memory_order_acquire);
+    Entry* entry = findInBucket(head, name, hash);
+    if (entry) {
+        return *entry;
+    }
+
+    std::lock_guard<std::mutex> lock(mtxShards[index % CHANNEL_REGISTRY_SHARDS]);
+
+    // somebody might have inserted it while we were waiting
+    head = buckets[index].load(std::memory_order_acquire);
+    entry = findInBucket(head, name, hash);
+    if (entry) {
+        return *entry;
+    }
+
+    std::unique_ptr<AbstractChannelBase> channel(create());
+    entry = new Entry { name, hash, type, std::move(channel), head };
+
+    // publish the completely constructed entry
+    buckets[index].store(entry, std::memory_order_release);
+    return *entry;
+}
+
+/**
+ * Calls visitor for every channel.
+ * Channels inserted concurrently may or may not be visited.
+ *
+ * @param visitor gets called with each Entry
+ */
+void ChannelRegistry::forEach(const std::function<void(Entry&)>& visitor) {
+    for (auto&& bucket : buckets) {
+        for (Entry* entry = bucket.load(std::memory_order_acquire); entry;
+                entry = entry->next) {
+            visitor(*entry);
+        }
+    }
+}
+
+/**
+ * @param head first Entry of a bucket
+ * @param name the name of the channel
+ * @param hash hash of name
+ * @return the Entry of the channel, or nullptr if it isn't in the bucket
+ */
+ChannelRegistry::Entry* ChannelRegistry::findInBucket(Entry* head,
+        const std::string& name, std::size_t hash) {
+    for (Entry* entry = head; entry; entry = entry->next) {
+        if (entry->hash == hash && entry->name == name) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+} /* namespace broking */
+/** @} */
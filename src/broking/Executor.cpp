@@ -0,0 +1,306 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#include "broking/Executor.h"
+
+#define LOG_MODULE "broking"
+#include "logging/logging.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace broking {
+
+/**
+ * The Executor the calling thread is a worker of, if any
+ */
+static thread_local Executor* currentExecutor = nullptr;
+
+/**
+ * Enters a Blocking section.
+ * If the calling worker's Executor has tasks that no idle worker can take,
+ * an additional worker is started.
+ */
+Executor::Blocking::Blocking() :
+        executor(currentExecutor) {
+    if (executor) {
+        std::lock_guard<std::mutex> lock(executor->mtxTasks);
+        ++executor->blockedWorkers;
+        if (executor->run && executor->tasks.size() > executor->idleWorkers
+                && executor->workers.size() < executor->workerLimit_()) {
+            executor->startWorker_();
+        }
+    }
+}
+
+/**
+ * Leaves the Blocking section.
+ * Additional workers terminate once they are idle for too long.
+ */
+Executor::Blocking::~Blocking() {
+    if (executor) {
+        std::lock_guard<std::mutex> lock(executor->mtxTasks);
+        --executor->blockedWorkers;
+    }
+}
+
+/**
+ * Constructs an Executor.
+ * No worker is started before the first task is executed.
+ *
+ * @param workerCount the number of workers to keep alive
+ * @param maxWorkerCount the maximum number of workers if the pool is elastic
+ *                       (values below workerCount disable elasticity)
+ */
+Executor::Executor(std::size_t workerCount, std::size_t maxWorkerCount) :
+        workerCount(std::max<std::size_t>(workerCount, 1)), maxWorkerCount(
+                maxWorkerCount), idleWorkers(0), parkedWorkers(0), blockedWorkers(0), run(true), signals(0) {
+    LOG_TRACE<< "Constructing Executor with " << this->workerCount
+    << " workers" << std::endl;
+}
+
+/**
+ * Destructs an Executor.
+ * Runs all pending tasks and joins the workers.
+ */
+Executor::~Executor() {
+    LOG_TRACE<< "Destructing Executor" << std::endl;
+
+    std::list<std::thread> remaining;
+    {
+        std::lock_guard<std::mutex> lock(mtxTasks);
+        run = false;
+        remaining.splice(remaining.end(), workers);
+        remaining.splice(remaining.end(), finishedWorkers);
+        signal_();
+    }
+    cvTasks.notify_all();
+
+    for (auto&& worker : remaining) {
+        worker.join();
+    }
+}
+
+/**
+ * Queue a task to be run by one of the workers.
+ * Starts a new worker if no worker is idle and the pool may still grow.
+ * While the Executor is destructed, only its own workers can queue tasks -
+ * they run them before terminating.
+ *
+ * @param task the task to run
+ * @attention an exception thrown by the task terminates the program
+ *
+ * @throws std::logic_error if called by another thread while the Executor is
+ *                          destructed
+ */
+void Executor::execute(std::function<void(void)> task) {
+    std::lock_guard<std::mutex> lock(mtxTasks);
+    if (!run && currentExecutor != this) {
+        throw std::logic_error("Executor is shutting down");
+    }
+    tasks.push_back(std::move(task));
+
+    // no new workers while shutting down - the destructor wouldn't join them
+    if (run && tasks.size() > idleWorkers && workers.size() < workerLimit_()) {
+        startWorker_();
+        return;
+    }
+    signal_();
+    if (parkedWorkers > 0) {
+        // idle workers that are spinning only need the signal
+        cvTasks.notify_one();
+    }
+}
+
+/**
+ * Changes the number of workers that are kept alive.
+ * Surplus workers terminate once they become idle.
+ *
+ * @param count the new number of workers
+ */
+void Executor::setWorkerCount(std::size_t count) {
+    std::lock_guard<std::mutex> lock(mtxTasks);
+    workerCount = std::max<std::size_t>(count, 1);
+    signal_();
+    cvTasks.notify_all();
+}
+
+/**
+ * Changes the maximum number of workers.
+ * Set it above the worker count to make the pool elastic.
+ *
+ * @param count the new maximum number of workers
+ */
+void Executor::setMaxWorkerCount(std::size_t count) {
+    std::lock_guard<std::mutex> lock(mtxTasks);
+    maxWorkerCount = count;
+    signal_();
+    cvTasks.notify_all();
+}
+
+/**
+ * Changes how idle workers wait for tasks.
+ * Spinning workers pick up a task faster, but keep their cores busy - only
+ * worth it with workers on dedicated cores, e.g. in a separate Executor for
+ * latency critical channels. Surplus elastic workers always park.
+ *
+ * @param strategy the new WaitStrategy
+ */
+void Executor::setWaitStrategy(WaitStrategy strategy) {
+    std::lock_guard<std::mutex> lock(mtxTasks);
+    waitStrategy = strategy;
+    signal_();
+    cvTasks.notify_all();
+}
+
+/**
+ * @return the number of workers that are kept alive
+ */
+std::size_t Executor::getWorkerCount() {
+    std::lock_guard<std::mutex> lock(mtxTasks);
+    return workerCount;
+}
+
+/**
+ * @return the number of currently running worker threads
+ */
+std::size_t Executor::getThreadCount() {
+    std::lock_guard<std::mutex> lock(mtxTasks);
+    return workers.size();
+}
+
+/**
+ * @return the number of hardware threads, but at least 1
+ */
+std::size_t Executor::defaultWorkerCount() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+/**
+ * Worker loop - run in each worker thread.
+ */
+void Executor::workerLoop() {
+    currentExecutor = this;
+    std::unique_lock<std::mutex> lock(mtxTasks);
+
+    while (true) {
+        if (!tasks.empty()) {
+            auto task = std::move(tasks.front());
+            tasks.pop_front();
+
+            lock.unlock();
+            task();
+            lock.lock();
+            continue;
+        }
+
+        if (!run) {
+            // destructor takes care of joining
+            return;
+        }
+
+        if (workers.size() > workerCount) {
+            // surplus worker -> terminate if idle for too long
+            ++idleWorkers;
+            ++parkedWorkers;
+            bool timeout = cvTasks.wait_for(lock, ELASTIC_WORKER_IDLE_TIMEOUT)
+                    == std::cv_status::timeout;
+            --parkedWorkers;
+            --idleWorkers;
+
+            if (timeout && run && tasks.empty()
+                    && workers.size() > workerCount) {
+                auto self = std::find_if(workers.begin(), workers.end(),
+                        [](const std::thread& t) {
+                            return t.get_id() == std::this_thread::get_id();
+                        });
+                finishedWorkers.splice(finishedWorkers.end(), workers, self);
+                return;
+            }
+        } else {
+            ++idleWorkers;
+            waitForTask_(lock);
+            --idleWorkers;
+        }
+    }
+}
+
+/**
+ * Waits for a notification according to the WaitStrategy: spins without
+ * holding the lock, then parks on cvTasks if the strategy allows it.
+ * @pre caller must hold lock on mtxTasks!
+ *
+ * @param lock the lock on mtxTasks
+ */
+void Executor::waitForTask_(std::unique_lock<std::mutex>& lock) {
+    if (waitStrategy.kind != WaitKind::BLOCK) {
+        WaitStrategy strategy = waitStrategy;
+        // every notification changes signals, so comparing it can't miss one
+        unsigned long seen = signals.load(std::memory_order_relaxed);
+        lock.unlock();
+        bool signalled = strategy.spinUntil([this, seen]() {
+            return signals.load(std::memory_order_acquire) != seen;
+        });
+        lock.lock();
+
+        if (signalled || signals.load(std::memory_order_relaxed) != seen
+                || !strategy.parks()) {
+            return;
+        }
+    }
+    ++parkedWorkers;
+    cvTasks.wait(lock);
+    --parkedWorkers;
+}
+
+/**
+ * Marks a notification of cvTasks for spinning workers.
+ * @pre caller must hold mtxTasks!
+ */
+void Executor::signal_() {
+    signals.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * @pre caller must hold mtxTasks!
+ *
+ * @return the number of workers the pool may grow to - blocked workers don't
+ *         count
+ */
+std::size_t Executor::workerLimit_() {
+    return std::max(workerCount, maxWorkerCount) + blockedWorkers;
+}
+
+/**
+ * Starts a new worker.
+ * @pre caller must hold mtxTasks!
+ */
+void Executor::startWorker_() {
+    joinFinishedWorkers_();
+    workers.emplace_back(&Executor::workerLoop, this);
+}
+
+/**
+ * Joins workers that terminated because they were idle.
+ * @pre caller must hold mtxTasks!
+ */
+void Executor::joinFinishedWorkers_() {
+    for (auto&& worker : finishedWorkers) {
+        // has already left workerLoop, so this won't block for long
+        worker.join();
+    }
+    finishedWorkers.clear();
+}
+
+} /* namespace broking */
+/** @} */
@@ -0,0 +1,169 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#include "broking/LatencyHistogram.h"
+
+#include <algorithm>
+
+namespace broking {
+
+/**
+ * Number of buckets per power of two
+ */
+static constexpr std::uint64_t SUB_BUCKETS = 1 << LATENCY_SUB_BUCKET_BITS;
+
+/**
+ * @param fraction the percentile as a fraction, e.g. 0.99
+ * @return the smallest bucket bound that at least fraction of the values are
+ *         below or equal to - 0 if there are no values
+ */
+std::chrono::nanoseconds LatencySnapshot::getPercentile(double fraction) const {
+    if (count == 0) {
+        return std::chrono::nanoseconds(0);
+    }
+
+    std::uint64_t rank = std::max<std::uint64_t>(1,
+            static_cast<std::uint64_t>(fraction * count + 0.5));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::chrono::nanoseconds(
+                    std::min(LatencyHistogram::upperBoundOf(i), max));
+        }
+    }
+    return std::chrono::nanoseconds(max);
+}
+
+/**
+ * @return the mean of all values - 0 if there are no values
+ */
+std::chrono::nanoseconds LatencySnapshot::getMean() const {
+    return std::chrono::nanoseconds(count == 0 ? 0 : sum / count);
+}
+
+/**
+ * Constructs an empty, disabled LatencyHistogram.
+ */
+LatencyHistogram::LatencyHistogram() :
+        enabled(false), enabledSince(0), count(0), sum(0), max(0) {
+    for (auto&& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Enables or disables recording.
+ *
+ * @param enable true to record values
+ */
+void LatencyHistogram::setEnabled(bool enable) {
+    if (enable && !enabled.load(std::memory_order_relaxed)) {
+        enabledSince.store(
+                std::chrono::steady_clock::now().time_since_epoch().count(),
+                std::memory_order_relaxed);
+    }
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+/**
+ * @retval true values are recorded
+ * @retval false values are ignored
+ */
+bool LatencyHistogram::isEnabled() const {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Records a value, regardless of whether recording is enabled.
+ *
+ * @param latency the value to record
+ */
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    std::uint64_t value = latency.count() < 0 ? 0 : latency.count();
+
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    std::uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current
+            && !max.compare_exchange_weak(current, value,
+                    std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * Copies the counters.
+ * Values recorded concurrently may only be partially visible in the copy.
+ *
+ * @return the copy
+ */
+LatencySnapshot LatencyHistogram::getSnapshot() const {
+    LatencySnapshot snapshot;
+    snapshot.buckets.reserve(LATENCY_BUCKETS);
+    for (auto&& bucket : buckets) {
+        snapshot.buckets.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    snapshot.count = count.load(std::memory_order_relaxed);
+    snapshot.sum = sum.load(std::memory_order_relaxed);
+    snapshot.max = max.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+/**
+ * Clears all counters.
+ * Values recorded concurrently may only be partially cleared.
+ */
+void LatencyHistogram::reset() {
+    for (auto&& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @param nanoseconds a value
+ * @return the index of the bucket the value is counted in
+ */
+std::size_t LatencyHistogram::bucketOf(std::uint64_t nanoseconds) {
+    if (nanoseconds < SUB_BUCKETS) {
+        return nanoseconds;
+    }
+    nanoseconds = std::min(nanoseconds,
+            (std::uint64_t(1) << LATENCY_MAX_EXPONENT) - 1);
+
+    // the highest set bit selects the power of two, the bits below it the
+    // sub-bucket
+    unsigned exponent = 63 - __builtin_clzll(nanoseconds);
+    unsigned shift = exponent - LATENCY_SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((nanoseconds >> shift) - SUB_BUCKETS);
+}
+
+/**
+ * @param bucket index of a bucket
+ * @return the largest value counted in the bucket
+ */
+std::uint64_t LatencyHistogram::upperBoundOf(std::size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    unsigned shift = bucket / SUB_BUCKETS - 1;
+    std::uint64_t lower = (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return lower + (std::uint64_t(1) << shift) - 1;
+}
+
+} /* namespace broking */
+/** @} */
@@ -0,0 +1,252 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#include "broking/TopicTrie.h"
+
+#define LOG_MODULE "broking"
+#include "logging/logging.h"
+
+#include <exception>
+#include <stdexcept>
+
+namespace broking {
+
+/**
+ * Matches exactly one level
+ */
+static const std::string SINGLE_LEVEL_WILDCARD = "*";
+
+/**
+ * Matches any number of levels - only allowed as the last level
+ */
+static const std::string MULTI_LEVEL_WILDCARD = "#";
+
+/**
+ * Constructs an empty TopicTrie.
+ */
+TopicTrie::TopicTrie() :
+        nextPatternID(0) {
+}
+
+/**
+ * Adds a new channel and attaches the subscribers of all matching patterns.
+ *
+ * @param name the name of the channel - must not have been added before
+ * @param type the type of the channel's messages
+ * @param channel the channel - must outlive the trie
+ */
+void TopicTrie::addChannel(const std::string& name, std::type_index type,
+        AbstractChannelBase& channel) {
+    std::vector<std::string> levels = split(name);
+    std::unique_ptr<ChannelInfo> info(new ChannelInfo { name, type, &channel });
+
+    std::lock_guard<std::mutex> lock(mtxTrie);
+    Node& node = insert_(levels);
+    matchPatterns_(root, levels, 0, *info);
+    // only known to later patterns once it is completely attached - if
+    // anything above throws, the caller deletes the channel
+    node.channel = std::move(info);
+}
+
+/**
+ * Adds a pattern and attaches its subscriber to all matching channels.
+ *
+ * @param pattern the pattern, e.g. `sensors.*.temperature` or `sensors.#`
+ * @param attach attaches the subscriber to a channel - called while the trie
+ *               is locked, so it must not create channels. If it throws, the
+ *               channel is skipped.
+ * @return the ID of the pattern, for removePattern
+ *
+ * @throws std::logic_error if `#` isn't the last level
+ */
+int TopicTrie::addPattern(const std::string& pattern, Attach attach) {
+    std::vector<std::string> levels = split(pattern);
+    for (std::size_t i = 0; i + 1 < levels.size(); ++i) {
+        if (levels[i] == MULTI_LEVEL_WILDCARD) {
+            throw std::logic_error(
+                    "\"" + MULTI_LEVEL_WILDCARD
+                            + "\" must be the last level of pattern \""
+                            + pattern + "\"");
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mtxTrie);
+    int id = nextPatternID++;
+    matchChannels_(root, levels, 0, attach);
+    insert_(levels).patterns.emplace(id, std::move(attach));
+    return id;
+}
+
+/**
+ * Removes a pattern - its subscriber isn't attached to new channels any more.
+ *
+ * @param pattern the pattern that was added
+ * @param id the ID returned by addPattern
+ */
+void TopicTrie::removePattern(const std::string& pattern, int id) {
+    std::vector<std::string> levels = split(pattern);
+
+    std::lock_guard<std::mutex> lock(mtxTrie);
+    insert_(levels).patterns.erase(id);
+}
+
+/**
+ * @param name a channel name or pattern
+ * @return the dot separated levels of name
+ */
+std::vector<std::string> TopicTrie::split(const std::string& name) {
+    std::vector<std::string> levels;
+    std::size_t start = 0;
+    while (true) {
+        std::size_t end = name.find('.', start);
+        if (end == std::string::npos) {
+            levels.push_back(name.substr(start));
+            return levels;
+        }
+        levels.push_back(name.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+/**
+ * Finds the node for a name, creating the missing levels.
+ * @pre caller must hold mtxTrie!
+ *
+ * @param levels the levels of the name
+ * @return the node of the last level
+ */
+TopicTrie::Node& TopicTrie::insert_(const std::vector<std::string>& levels) {
+    Node* node = &root;
+    for (auto&& level : levels) {
+        std::unique_ptr<Node>& child = node->children[level];
+        if (!child) {
+            child.reset(new Node());
+        }
+        node = child.get();
+    }
+    return *node;
+}
+
+/**
+ * Attaches the subscribers of all patterns below node that match the rest of
+ * a channel name.
+ * @pre caller must hold mtxTrie!
+ *
+ * @param node the node of the levels before index
+ * @param levels the levels of the channel name
+ * @param index the first level that is not matched yet
+ * @param info the channel
+ */
+void TopicTrie::matchPatterns_(Node& node,
+        const std::vector<std::string>& levels, std::size_t index,
+        const ChannelInfo& info) {
+    // '#' matches the rest, however many levels are left
+    auto multi = node.children.find(MULTI_LEVEL_WILDCARD);
+    if (multi != node.children.end()) {
+        for (auto&& pattern : multi->second->patterns) {
+            attach_(pattern.second, info);
+        }
+    }
+
+    if (index == levels.size()) {
+        for (auto&& pattern : node.patterns) {
+            attach_(pattern.second, info);
+        }
+        return;
+    }
+
+    const std::string& level = levels[index];
+    auto single = node.children.find(SINGLE_LEVEL_WILDCARD);
+    if (single != node.children.end()) {
+        matchPatterns_(*single->second, levels, index + 1, info);
+    }
+
+    // a channel level named like a wildcard was matched above already
+    if (level != SINGLE_LEVEL_WILDCARD && level != MULTI_LEVEL_WILDCARD) {
+        auto exact = node.children.find(level);
+        if (exact != node.children.end()) {
+            matchPatterns_(*exact->second, levels, index + 1, info);
+        }
+    }
+}
+
+/**
+ * Attaches a subscriber to all channels below node that match the rest of a
+ * pattern.
+ * @pre caller must hold mtxTrie!
+ *
+ * @param node the node of the levels before index
+ * @param levels the levels of the pattern
+ * @param index the first level that is not matched yet
+ * @param attach attaches the subscriber to a channel
+ */
+void TopicTrie::matchChannels_(Node& node,
+        const std::vector<std::string>& levels, std::size_t index,
+        const Attach& attach) {
+    if (index == levels.size()) {
+        if (node.channel) {
+            attach_(attach, *node.channel);
+        }
+        return;
+    }
+
+    const std::string& level = levels[index];
+    if (level == MULTI_LEVEL_WILDCARD) {
+        attachSubtree_(node, attach);
+    } else if (level == SINGLE_LEVEL_WILDCARD) {
+        for (auto&& child : node.children) {
+            matchChannels_(*child.second, levels, index + 1, attach);
+        }
+    } else {
+        auto exact = node.children.find(level);
+        if (exact != node.children.end()) {
+            matchChannels_(*exact->second, levels, index + 1, attach);
+        }
+    }
+}
+
+/**
+ * Attaches a subscriber to the channel of node and all channels below it.
+ * @pre caller must hold mtxTrie!
+ *
+ * @param node the node
+ * @param attach attaches the subscriber to a channel
+ */
+void TopicTrie::attachSubtree_(Node& node, const Attach& attach) {
+    if (node.channel) {
+        attach_(attach, *node.channel);
+    }
+    for (auto&& child : node.children) {
+        attachSubtree_(*child.second, attach);
+    }
+}
+
+/**
+ * Attaches a subscriber to a channel.
+ * A subscriber that can't be attached only misses this channel - it doesn't
+ * keep the channel from being created or other subscribers from attaching.
+ *
+ * @param attach attaches the subscriber to a channel
+ * @param info the channel
+ */
+void TopicTrie::attach_(const Attach& attach, const ChannelInfo& info) {
+    try {
+        attach(info);
+    } catch (const std::exception& e) {
+        LOG_ERROR << "Failed to attach a wildcard subscription to Channel \""
+        << info.name << "\" - " << e.what() << std::endl;
+    }
+}
+
+} /* namespace broking */
+/** @} */
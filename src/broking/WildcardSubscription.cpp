@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Broking
+ * @{
+ */
+
+#include "broking/WildcardSubscription.h"
+
+#include <utility>
+
+namespace broking {
+
+/**
+ * Constructs an invalid WildcardSubscription
+ */
+WildcardSubscription::WildcardSubscription() :
+        topics(nullptr), id(-1) {
+}
+
+/**
+ * Constructs a WildcardSubscription.
+ *
+ * @param topics the trie the pattern is registered in
+ * @param pattern the pattern
+ * @param id ID of the pattern in the trie
+ * @param channels gets a Subscription for every matching channel
+ */
+WildcardSubscription::WildcardSubscription(TopicTrie& topics,
+        std::string pattern, int id, std::shared_ptr<Channels> channels) :
+        topics(&topics), pattern(std::move(pattern)), id(id), channels(
+                std::move(channels)) {
+}
+
+/**
+ * Move Construction.
+ * Will take responsibility for the subscription away from other.
+ *
+ * @param other the WildcardSubscription to be transferred to this.
+ */
+WildcardSubscription::WildcardSubscription(WildcardSubscription&& other) :
+        topics(other.topics), pattern(std::move(other.pattern)), id(other.id), channels(
+                std::move(other.channels)) {
+    other.topics = nullptr;
+    other.id = -1;
+}
+
+/**
+ * Move assignment.
+ * This will take responsibility for the subscription away from other.
+ *
+ * @param other the WildcardSubscription to be transferred to this.
+ * @return this
+ */
+WildcardSubscription& WildcardSubscription::operator =(
+        WildcardSubscription&& other) {
+    // In case we were subscribed, we need to unsubscribe first.
+    unsubscribe();
+
+    topics = other.topics;
+    pattern = std::move(other.pattern);
+    id = other.id;
+    channels = std::move(other.channels);
+
+    other.topics = nullptr;
+    other.id = -1;
+
+    return *this;
+}
+
+/**
+ * Destructs a WildcardSubscription.
+ * Unsubscribes from all channels.
+ */
+WildcardSubscription::~WildcardSubscription() {
+    unsubscribe();
+}
+
+/**
+ * @return the pattern
+ */
+const std::string& WildcardSubscription::getPattern() const {
+    return pattern;
+}
+
+/**
+ * @return the number of channels the subscription is attached to
+ * @attention may change concurrently while channels are created
+ */
+std::size_t WildcardSubscription::getChannelCount() const {
+    return channels ? channels->count.load(std::memory_order_relaxed) : 0;
+}
+
+/**
+ * Stops attaching to new channels and unsubscribes from all channels.
+ */
+void WildcardSubscription::unsubscribe() {
+    if (topics) {
+        // no channel is attached after this returns
+        topics->removePattern(pattern, id);
+        topics = nullptr;
+        id = -1;
+
+        // removePattern locked the trie, so nothing is attached concurrently
+        for (auto&& subscription : channels->subscriptions) {
+            subscription.unsubscribe();
+        }
+        channels->subscriptions.clear();
+        channels->count.store(0, std::memory_order_relaxed);
+    }
+}
+
+} /* namespace broking */
+/** @} */
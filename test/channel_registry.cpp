@@ -0,0 +1,108 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Tests ChannelRegistry: every channel is created exactly once, even if
+ * several threads ask for it at the same time, and lookups find it.
+ */
+
+#include "test.h"
+#include "broking/broking.h"
+#include "broking/ChannelRegistry.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <vector>
+
+/**
+ * Number of distinct channels
+ */
+constexpr int CHANNELS = 500;
+
+/**
+ * Number of threads that create the channels concurrently
+ */
+constexpr int THREADS = 4;
+
+/**
+ * Concurrent findOrCreate calls for the same names create every channel once
+ * and all return the same Entry.
+ */
+static void testConcurrentCreation() {
+    ChannelRegistry registry;
+    std::atomic<int> created(0);
+    std::vector<std::vector<ChannelRegistry::Entry*>> entries(THREADS,
+            std::vector<ChannelRegistry::Entry*>(CHANNELS));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&registry, &created, &entries, t]() {
+            for (int i = 0; i < CHANNELS; ++i) {
+                // every thread starts at a different name
+                int index = (i + t * CHANNELS / THREADS) % CHANNELS;
+                std::string name = "test.registry." + std::to_string(index);
+                ChannelRegistry::Entry& entry = registry.findOrCreate(name,
+                        typeid(int), [&created, &name]() {
+                            ++created;
+                            return new Channel<int>(name);
+                        });
+                entries[t][index] = &entry;
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(created == CHANNELS);
+    for (int i = 0; i < CHANNELS; ++i) {
+        std::string name = "test.registry." + std::to_string(i);
+        ChannelRegistry::Entry* entry = registry.find(name);
+        CHECK(entry && entry->name == name && entry->type == typeid(int));
+        for (int t = 0; t < THREADS; ++t) {
+            CHECK(entries[t][i] == entry);
+        }
+    }
+
+    int visited = 0;
+    registry.forEach([&visited](ChannelRegistry::Entry&) {
+        ++visited;
+    });
+    CHECK(visited == CHANNELS);
+}
+
+/**
+ * Looking up a channel that doesn't exist finds nothing and an existing
+ * channel is returned without calling create.
+ */
+static void testLookup() {
+    ChannelRegistry registry;
+    CHECK(registry.find("test.registry.missing") == nullptr);
+
+    ChannelRegistry::Entry& entry = registry.findOrCreate("test.registry.one",
+            typeid(double), []() {
+                return new Channel<double>("test.registry.one");
+            });
+    bool createdAgain = false;
+    ChannelRegistry::Entry& again = registry.findOrCreate("test.registry.one",
+            typeid(double), [&createdAgain]() {
+                createdAgain = true;
+                return new Channel<double>("test.registry.one");
+            });
+    CHECK(&entry == &again);
+    CHECK(!createdAgain);
+    CHECK(registry.find("test.registry.one") == &entry);
+}
+
+int main() {
+    testConcurrentCreation();
+    testLookup();
+    return test::finish("channel_registry");
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Tests MPMCQueue: order under several producers, wraparound and elements
+ * whose constructor throws - in the queue and through a Channel.
+ */
+
+#include "test.h"
+#include "broking/broking.h"
+#include "broking/MPMCQueue.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/**
+ * A message that throws when it is constructed from a negative value or
+ * copied while flagged.
+ */
+struct Fragile {
+    int value; ///< the payload
+    bool throwOnCopy; ///< the copy constructor throws if set
+
+    /**
+     * @param value the payload - throws if negative
+     * @param throwOnCopy makes the copy constructor throw
+     */
+    explicit Fragile(int value, bool throwOnCopy = false) :
+            value(value), throwOnCopy(throwOnCopy) {
+        if (value < 0) {
+            throw std::runtime_error("negative value");
+        }
+    }
+
+    /**
+     * Copy Constructor - throws if other is flagged.
+     */
+    Fragile(const Fragile& other) :
+            value(other.value), throwOnCopy(other.throwOnCopy) {
+        if (throwOnCopy) {
+            throw std::runtime_error("copy failed");
+        }
+    }
+
+    /**
+     * Move Constructor
+     */
+    Fragile(Fragile&& other) noexcept = default;
+
+    /**
+     * Copy assignment
+     */
+    Fragile& operator=(const Fragile&) = default;
+
+    /**
+     * Move assignment
+     */
+    Fragile& operator=(Fragile&&) = default;
+};
+
+/**
+ * Every producer's messages arrive complete and in the order they were
+ * enqueued.
+ */
+static void testOrderWithSeveralProducers() {
+    constexpr int PRODUCERS = 4;
+    constexpr int MESSAGES = 20000;
+    MPMCQueue<int> queue(16);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < MESSAGES; ++i) {
+                queue.enqueue(p * MESSAGES + i);
+            }
+        });
+    }
+
+    std::vector<int> next(PRODUCERS, 0);
+    bool inOrder = true;
+    for (int i = 0; i < PRODUCERS * MESSAGES; ++i) {
+        int message = queue.dequeue();
+        int producer = message / MESSAGES;
+        inOrder = inOrder && message % MESSAGES == next[producer];
+        next[producer] = message % MESSAGES + 1;
+    }
+    for (auto&& producer : producers) {
+        producer.join();
+    }
+
+    CHECK(inOrder);
+    for (int p = 0; p < PRODUCERS; ++p) {
+        CHECK(next[p] == MESSAGES);
+    }
+    CHECK(!queue.tryDequeue());
+}
+
+/**
+ * Slots are reused correctly after many laps, and the capacity is rounded up
+ * to a power of two.
+ */
+static void testWraparound() {
+    MPMCQueue<int> queue(5);
+    CHECK(queue.capacity() == 8);
+
+    for (int i = 0; i < 8; ++i) {
+        CHECK(queue.tryEnqueue(i));
+    }
+    CHECK(!queue.tryEnqueue(8));
+    CHECK(queue.size() == 8);
+
+    bool fifo = true;
+    for (int i = 8; i < 1000; ++i) {
+        auto message = queue.tryDequeue();
+        fifo = fifo && message && *message == i - 8;
+        fifo = fifo && queue.tryEnqueue(i);
+    }
+    CHECK(fifo);
+    for (int i = 992; i < 1000; ++i) {
+        auto message = queue.tryDequeue();
+        CHECK(message && *message == i);
+    }
+    CHECK(!queue.tryDequeue());
+}
+
+/**
+ * A throwing constructor leaves nothing in the queue and doesn't block the
+ * elements behind it.
+ */
+static void testThrowingConstructor() {
+    MPMCQueue<Fragile> queue(4);
+    CHECK(queue.tryEmplace(1));
+
+    bool thrown = false;
+    try {
+        queue.tryEmplace(-1);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    CHECK(queue.tryEmplace(2));
+    auto first = queue.tryDequeue();
+    CHECK(first && first->value == 1);
+    auto second = queue.tryDequeue();
+    CHECK(second && second->value == 2);
+    CHECK(!queue.tryDequeue());
+
+    // the skipped slot can be used again
+    for (int i = 0; i < 4; ++i) {
+        CHECK(queue.tryEmplace(i));
+    }
+    for (int i = 0; i < 4; ++i) {
+        auto message = queue.tryDequeue();
+        CHECK(message && message->value == i);
+    }
+}
+
+/**
+ * A consumer that waits in dequeue gets past a slot whose constructor threw.
+ */
+static void testThrowingConstructorWithWaitingConsumer() {
+    MPMCQueue<Fragile> queue(4);
+    std::atomic<int> received(-1);
+    std::thread consumer([&queue, &received]() {
+        received = queue.dequeue().value;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    try {
+        queue.emplace(-1);
+    } catch (const std::runtime_error&) {
+    }
+    queue.emplace(3);
+
+    if (!test::waitFor([&received]() {return received == 3;})) {
+        // the consumer is stuck for good - it can't be joined
+        CHECK(received == 3);
+        std::exit(test::finish("mpmc_queue"));
+    }
+    consumer.join();
+}
+
+/**
+ * A Channel keeps delivering after copying a published message threw.
+ */
+static void testChannelAfterThrowingCopy() {
+    Channel<Fragile> channel("test.mpmc.fragile");
+    std::mutex mtx;
+    std::vector<int> received;
+    auto subscription = channel.subscribe([&mtx, &received](Fragile message) {
+        std::lock_guard<std::mutex> lock(mtx);
+        received.push_back(message.value);
+    });
+
+    channel.publish(Fragile(1));
+    Fragile fragile(2, true);
+    bool thrown = false;
+    try {
+        channel.publish(fragile);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    channel.publish(Fragile(3));
+    CHECK(channel.tryPublish(Fragile(4)));
+
+    CHECK(test::waitFor([&mtx, &received]() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return received.size() == 3;
+    }));
+    std::lock_guard<std::mutex> lock(mtx);
+    CHECK(received == std::vector<int>( { 1, 3, 4 }));
+}
+
+int main() {
+    testOrderWithSeveralProducers();
+    testWraparound();
+    testThrowingConstructor();
+    testThrowingConstructorWithWaitingConsumer();
+    testChannelAfterThrowingCopy();
+    return test::finish("mpmc_queue");
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Tests parallel fan-out: with the subscribers split into partitions, every
+ * subscriber still gets every message it accepts, in publishing order.
+ */
+
+#include "test.h"
+#include "broking/broking.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * Number of callback subscribers
+ */
+constexpr int SUBSCRIBERS = 40;
+
+/**
+ * Number of published messages
+ */
+constexpr int MESSAGES = 1000;
+
+/**
+ * Every subscriber gets all messages in order - also with fewer workers than
+ * partitions and with a filter.
+ */
+static void testOrderPerSubscriber(std::size_t workers, std::size_t partitions) {
+    Executor executor(workers);
+    Channel<int> channel("test.fanout", executor);
+    channel.setParallelFanOut(partitions);
+
+    // each subscriber is only ever called by one worker at a time
+    std::vector<std::vector<int>> received(SUBSCRIBERS);
+    std::atomic<int> done(0);
+    std::vector<Subscription> subscriptions;
+    for (int s = 0; s < SUBSCRIBERS; ++s) {
+        subscriptions.push_back(channel.subscribe(
+                [&received, &done, s](int message) {
+                    received[s].push_back(message);
+                    if (message == MESSAGES - 1) {
+                        ++done;
+                    }
+                }));
+    }
+    std::vector<int> even;
+    auto filtered = channel.subscribe([](const int& message) {
+        return message % 2 == 0;
+    }, [&even](int message) {
+        even.push_back(message);
+    });
+
+    for (int i = 0; i < MESSAGES; ++i) {
+        channel.publish(i);
+    }
+    CHECK(test::waitFor([&done]() {return done == SUBSCRIBERS;}));
+    // all partitions finish a message before the next one is dispatched, so
+    // the filtered subscriber is done as well
+
+    bool inOrder = true;
+    for (auto&& messages : received) {
+        inOrder = inOrder && messages.size() == MESSAGES;
+        for (std::size_t i = 0; inOrder && i < messages.size(); ++i) {
+            inOrder = messages[i] == static_cast<int>(i);
+        }
+    }
+    CHECK(inOrder);
+    CHECK(even.size() == MESSAGES / 2);
+    CHECK(!even.empty() && even.back() == MESSAGES - 2);
+
+    // the last deliveries are counted after the callbacks returned
+    CHECK(test::waitFor([&channel]() {
+        return channel.getStats().delivered
+                == SUBSCRIBERS * MESSAGES + MESSAGES / 2;
+    }));
+}
+
+int main() {
+    testOrderPerSubscriber(4, 4);
+    testOrderPerSubscriber(1, 8);
+    return test::finish("parallel_fanout");
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Tests PartitionedChannel: every key stays in one partition and the
+ * messages of a key arrive in publishing order.
+ */
+
+#include "test.h"
+#include "broking/broking.h"
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of distinct keys
+ */
+constexpr long KEYS = 64;
+
+/**
+ * Number of messages published for every key
+ */
+constexpr long MESSAGES_PER_KEY = 200;
+
+/**
+ * Number of producer threads - each one publishes the keys k with
+ * k % PRODUCERS == p, so the order per key is well defined
+ */
+constexpr int PRODUCERS = 2;
+
+/**
+ * Number of partitions
+ */
+constexpr std::size_t PARTITIONS = 4;
+
+/**
+ * Messages are key * MESSAGES_PER_KEY + sequence number.
+ * Several producers publish concurrently; every key arrives complete, in
+ * order, and only from one partition.
+ */
+static void testOrderPerKey() {
+    Executor executor(PARTITIONS);
+    PartitionedChannel<long> channel("test.partitioned", PARTITIONS,
+            [](long message) {return message / MESSAGES_PER_KEY;}, executor);
+
+    std::mutex mtx;
+    // next expected sequence number per key
+    std::map<long, long> next;
+    std::map<long, std::set<std::size_t>> partitionsOfKey;
+    bool inOrder = true;
+    std::vector<Subscription> subscriptions;
+    for (std::size_t i = 0; i < PARTITIONS; ++i) {
+        subscriptions.push_back(channel.getPartition(i).subscribe(
+                [&, i](long message) {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    long key = message / MESSAGES_PER_KEY;
+                    inOrder = inOrder && message % MESSAGES_PER_KEY == next[key];
+                    next[key] = message % MESSAGES_PER_KEY + 1;
+                    partitionsOfKey[key].insert(i);
+                }));
+    }
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&channel, p]() {
+            for (long i = 0; i < MESSAGES_PER_KEY; ++i) {
+                for (long key = p; key < KEYS; key += PRODUCERS) {
+                    channel.publish(key * MESSAGES_PER_KEY + i);
+                }
+            }
+        });
+    }
+    for (auto&& producer : producers) {
+        producer.join();
+    }
+
+    CHECK(test::waitFor([&mtx, &next]() {
+        std::lock_guard<std::mutex> lock(mtx);
+        long received = 0;
+        for (auto&& key : next) {
+            received += key.second;
+        }
+        return received == KEYS * MESSAGES_PER_KEY;
+    }));
+
+    std::lock_guard<std::mutex> lock(mtx);
+    CHECK(inOrder);
+    CHECK(partitionsOfKey.size() == static_cast<std::size_t>(KEYS));
+    std::set<std::size_t> used;
+    for (auto&& key : partitionsOfKey) {
+        CHECK(key.second.size() == 1);
+        CHECK(*key.second.begin() == channel.partitionOf(
+                key.first * MESSAGES_PER_KEY));
+        used.insert(key.second.begin(), key.second.end());
+    }
+    // 64 keys don't all hash to the same partition
+    CHECK(used.size() > 1);
+}
+
+/**
+ * A batch is split by key and every part goes to its partition.
+ */
+static void testBatch() {
+    PartitionedChannel<long> channel("test.partitioned.batch", PARTITIONS,
+            [](long message) {return message;});
+    std::mutex mtx;
+    std::vector<long> received;
+    auto subscriptions = channel.subscribe([&mtx, &received](long message) {
+        std::lock_guard<std::mutex> lock(mtx);
+        received.push_back(message);
+    });
+
+    std::vector<long> batch;
+    for (long i = 0; i < 100; ++i) {
+        batch.push_back(i);
+    }
+    channel.publish(std::move(batch));
+
+    CHECK(test::waitFor([&mtx, &received]() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return received.size() == 100;
+    }));
+    std::lock_guard<std::mutex> lock(mtx);
+    CHECK(std::set<long>(received.begin(), received.end()).size() == 100);
+}
+
+int main() {
+    testOrderPerKey();
+    testBatch();
+    return test::finish("partitioned_channel");
+}
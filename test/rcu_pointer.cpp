@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Tests RcuPointer: readers keep the value they saw alive, replaced values
+ * are deleted once no reader can see them, and concurrent readers only see
+ * values that are alive.
+ */
+
+#include "test.h"
+#include "broking/RcuPointer.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using broking::RcuPointer;
+
+/**
+ * A value that counts how many instances are alive.
+ */
+struct Tracked {
+    static std::atomic<int> alive; ///< number of instances
+    int value; ///< the payload
+    bool destroyed; ///< set by the destructor, to detect reads after delete
+
+    /**
+     * @param value the payload
+     */
+    explicit Tracked(int value) :
+            value(value), destroyed(false) {
+        ++alive;
+    }
+
+    /**
+     * Destructor
+     */
+    ~Tracked() {
+        destroyed = true;
+        --alive;
+    }
+};
+
+/**
+ * Definition of Tracked::alive
+ */
+std::atomic<int> Tracked::alive(0);
+
+/**
+ * A read section keeps the value it saw, and the value is deleted after the
+ * read section is left.
+ */
+static void testReclamation() {
+    {
+        RcuPointer<Tracked> rcu(std::unique_ptr<Tracked>(new Tracked(1)));
+        CHECK(Tracked::alive == 1);
+        CHECK(!rcu.isReadByThisThread());
+
+        {
+            RcuPointer<Tracked>::ReadGuard reader(rcu);
+            CHECK(rcu.isReadByThisThread());
+            rcu.update(std::unique_ptr<Tracked>(new Tracked(2)));
+
+            // the reader still sees the old value, so it must not be deleted
+            CHECK(reader->value == 1);
+            CHECK(Tracked::alive == 2);
+
+            RcuPointer<Tracked>::ReadGuard nested(rcu);
+            CHECK(nested->value == 2);
+        }
+        CHECK(!rcu.isReadByThisThread());
+
+        rcu.synchronize();
+        CHECK(Tracked::alive == 1);
+
+        // without readers, replaced values don't pile up
+        for (int i = 3; i < 100; ++i) {
+            rcu.update(std::unique_ptr<Tracked>(new Tracked(i)));
+        }
+        CHECK(Tracked::alive <= 3);
+        RcuPointer<Tracked>::ReadGuard reader(rcu);
+        CHECK(reader->value == 99);
+    }
+    CHECK(Tracked::alive == 0);
+}
+
+/**
+ * Readers on other threads see the values in the order they were stored and
+ * never a deleted one.
+ */
+static void testConcurrentReaders() {
+    constexpr int UPDATES = 20000;
+    constexpr int READERS = 3;
+    RcuPointer<Tracked> rcu(std::unique_ptr<Tracked>(new Tracked(0)));
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; ++r) {
+        readers.emplace_back([&rcu, &done, &failures]() {
+            int last = 0;
+            while (!done) {
+                RcuPointer<Tracked>::ReadGuard reader(rcu);
+                if (reader->destroyed || reader->value < last) {
+                    ++failures;
+                }
+                last = reader->value;
+            }
+        });
+    }
+
+    for (int i = 1; i <= UPDATES; ++i) {
+        rcu.update(std::unique_ptr<Tracked>(new Tracked(i)));
+    }
+    done = true;
+    for (auto&& reader : readers) {
+        reader.join();
+    }
+
+    CHECK(failures == 0);
+    rcu.synchronize();
+    CHECK(Tracked::alive == 1);
+}
+
+int main() {
+    testReclamation();
+    testConcurrentReaders();
+    return test::finish("rcu_pointer");
+}
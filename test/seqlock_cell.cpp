@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Tests SeqLockCell: empty before the first store, and readers never see a
+ * value that is half written.
+ */
+
+#include "test.h"
+#include "broking/SeqLockCell.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using broking::SeqLockCell;
+
+/**
+ * A value that spans several words - all of them are always equal.
+ */
+struct Wide {
+    long words[4]; ///< the payload
+};
+
+/**
+ * The cell is empty until the first store and then returns the latest value.
+ */
+static void testStoreAndLoad() {
+    SeqLockCell<int> cell;
+    CHECK(!cell.load());
+
+    cell.store(1);
+    auto value = cell.load();
+    CHECK(value && *value == 1);
+
+    cell.store(2);
+    value = cell.load();
+    CHECK(value && *value == 2);
+}
+
+/**
+ * Readers on other threads never see a torn value and see the values in the
+ * order they were stored.
+ */
+static void testNoTornReads() {
+    constexpr long STORES = 200000;
+    constexpr int READERS = 3;
+    SeqLockCell<Wide> cell;
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; ++r) {
+        readers.emplace_back([&cell, &done, &failures]() {
+            long last = 0;
+            while (!done) {
+                auto value = cell.load();
+                if (!value) {
+                    continue;
+                }
+                bool torn = false;
+                for (long word : value->words) {
+                    torn = torn || word != value->words[0];
+                }
+                if (torn || value->words[0] < last) {
+                    ++failures;
+                }
+                last = value->words[0];
+            }
+        });
+    }
+
+    for (long i = 1; i <= STORES; ++i) {
+        cell.store(Wide { { i, i, i, i } });
+    }
+    done = true;
+    for (auto&& reader : readers) {
+        reader.join();
+    }
+
+    CHECK(failures == 0);
+    auto value = cell.load();
+    CHECK(value && value->words[3] == STORES);
+}
+
+int main() {
+    testStoreAndLoad();
+    testNoTornReads();
+    return test::finish("seqlock_cell");
+}
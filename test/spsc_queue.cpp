@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Tests SPSCQueue: order across wraparound with a concurrent producer,
+ * draining, and sinks and constructors that throw.
+ */
+
+#include "test.h"
+#include "broking/SPSCQueue.h"
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using broking::SPSCQueue;
+
+/**
+ * Messages arrive complete and in order while the ring wraps around many
+ * times.
+ */
+static void testOrderAcrossWraparound() {
+    constexpr int MESSAGES = 100000;
+    SPSCQueue<int> queue(3);
+    CHECK(queue.capacity() == 3);
+
+    std::thread producer([&queue]() {
+        for (int i = 0; i < MESSAGES; ++i) {
+            while (!queue.tryEnqueue(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    bool inOrder = true;
+    for (int i = 0; i < MESSAGES; ++i) {
+        inOrder = inOrder && queue.dequeue() == i;
+    }
+    producer.join();
+
+    CHECK(inOrder);
+    CHECK(!queue.tryDequeue());
+}
+
+/**
+ * The queue is full at its capacity and drain takes at most max messages in
+ * order.
+ */
+static void testDrain() {
+    SPSCQueue<int> queue(4);
+    for (int i = 0; i < 4; ++i) {
+        CHECK(queue.tryEnqueue(i));
+    }
+    CHECK(!queue.tryEnqueue(4));
+    CHECK(queue.size() == 4);
+
+    std::vector<int> drained;
+    CHECK(queue.drain([&drained](int&& message) {
+        drained.push_back(message);
+    }, 3) == 3);
+    CHECK(drained == std::vector<int>( { 0, 1, 2 }));
+    CHECK(queue.size() == 1);
+
+    CHECK(queue.tryEnqueue(4));
+    CHECK(queue.drain([&drained](int&& message) {
+        drained.push_back(message);
+    }, 10) == 2);
+    CHECK(drained == std::vector<int>( { 0, 1, 2, 3, 4 }));
+}
+
+/**
+ * A sink that throws keeps the messages it didn't take in the queue.
+ */
+static void testThrowingSink() {
+    SPSCQueue<std::string> queue(4);
+    for (int i = 0; i < 4; ++i) {
+        CHECK(queue.tryEnqueue(std::to_string(i)));
+    }
+
+    std::vector<std::string> drained;
+    bool thrown = false;
+    try {
+        queue.drain([&drained](std::string&& message) {
+            if (message == "2") {
+                throw std::runtime_error("sink failed");
+            }
+            drained.push_back(std::move(message));
+        }, 4);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(drained == std::vector<std::string>( { "0", "1" }));
+
+    // the message the sink threw on is consumed, the rest is still there
+    CHECK(queue.size() == 1);
+    auto message = queue.tryDequeue();
+    CHECK(message && *message == "3");
+    CHECK(queue.tryEnqueue("4"));
+}
+
+/**
+ * A constructor that throws leaves nothing in the queue.
+ */
+static void testThrowingConstructor() {
+    SPSCQueue<std::vector<int>> queue(2);
+    bool thrown = false;
+    try {
+        // std::vector throws std::length_error for a too large size
+        queue.tryEmplace(std::vector<int>().max_size() + 1);
+    } catch (const std::exception&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(queue.size() == 0);
+    CHECK(queue.tryEmplace(3, 7));
+    auto message = queue.tryDequeue();
+    CHECK(message && *message == std::vector<int>( { 7, 7, 7 }));
+}
+
+int main() {
+    testOrderAcrossWraparound();
+    testDrain();
+    testThrowingSink();
+    testThrowingConstructor();
+    return test::finish("spsc_queue");
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Minimal harness shared by the tests.
+ * A failed CHECK prints its location and condition, the test keeps running
+ * and finish() reports the result as the exit code.
+ */
+
+#ifndef TEST_TEST_H_
+#define TEST_TEST_H_
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+/**
+ * Checks a condition and records a failure if it doesn't hold.
+ */
+#define CHECK(condition) \
+    test::check((condition), #condition, __FILE__, __LINE__)
+
+namespace test {
+
+/**
+ * @return the number of failed checks so far
+ */
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+/**
+ * Records a failure if a condition doesn't hold - use CHECK instead.
+ *
+ * @param ok the result of the condition
+ * @param condition the condition as text
+ * @param file the file of the check
+ * @param line the line of the check
+ */
+inline void check(bool ok, const char* condition, const char* file, int line) {
+    if (!ok) {
+        ++failures();
+        std::cerr << file << ":" << line << ": CHECK(" << condition
+                << ") failed" << std::endl;
+    }
+}
+
+/**
+ * Waits until a condition holds.
+ *
+ * @param condition the condition
+ * @param timeout gives up after this long
+ * @retval true the condition holds
+ * @retval false the condition didn't hold within timeout
+ */
+template<typename Condition>
+inline bool waitFor(Condition condition, std::chrono::milliseconds timeout =
+        std::chrono::milliseconds(5000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+/**
+ * Reports the result of a test.
+ *
+ * @param name name of the test
+ * @return exit code for main - 0 if no check failed
+ */
+inline int finish(const char* name) {
+    if (failures() == 0) {
+        std::cout << name << ": passed" << std::endl;
+        return 0;
+    }
+    std::cout << name << ": " << failures() << " check(s) failed" << std::endl;
+    return 1;
+}
+
+} /* namespace test */
+
+#endif /* TEST_TEST_H_ */
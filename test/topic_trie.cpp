@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Tests TopicTrie: matching of `*` and `#`, patterns that are added before
+ * their channels, and removing patterns.
+ */
+
+#include "test.h"
+#include "broking/broking.h"
+#include "broking/TopicTrie.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+/**
+ * Names of the channels that are added to the trie
+ */
+static const std::vector<std::string> NAMES { "a", "a.b", "a.b.c", "a.x.c",
+        "a.b.c.d", "b.b.c" };
+
+/**
+ * A trie with a channel for every name in NAMES.
+ */
+struct Fixture {
+    TopicTrie topics; ///< the trie
+    std::vector<std::unique_ptr<Channel<int>>> channels; ///< the channels in the trie
+
+    /**
+     * Adds a channel for every name in NAMES.
+     */
+    Fixture() {
+        for (auto&& name : NAMES) {
+            channels.emplace_back(new Channel<int>("test.trie." + name));
+            topics.addChannel(name, typeid(int), *channels.back());
+        }
+    }
+
+    /**
+     * Adds a pattern that records the names of the channels it is attached
+     * to.
+     *
+     * @param pattern the pattern
+     * @param attached gets the names of the matching channels
+     * @return the ID of the pattern
+     */
+    int addPattern(const std::string& pattern,
+            std::vector<std::string>& attached) {
+        return topics.addPattern(pattern,
+                [&attached](const TopicTrie::ChannelInfo& info) {
+                    attached.push_back(info.name);
+                });
+    }
+};
+
+/**
+ * @param pattern a pattern
+ * @return the sorted names of the channels in NAMES that match the pattern
+ */
+static std::vector<std::string> match(const std::string& pattern) {
+    Fixture fixture;
+    std::vector<std::string> attached;
+    fixture.addPattern(pattern, attached);
+    std::sort(attached.begin(), attached.end());
+    return attached;
+}
+
+/**
+ * `*` matches exactly one level, `#` any number of levels including none.
+ */
+static void testMatching() {
+    using Names = std::vector<std::string>;
+    CHECK(match("a.b") == Names( { "a.b" }));
+    CHECK(match("a.*.c") == Names( { "a.b.c", "a.x.c" }));
+    CHECK(match("*.b.c") == Names( { "a.b.c", "b.b.c" }));
+    CHECK(match("*") == Names( { "a" }));
+    CHECK(match("a.#") == Names( { "a", "a.b", "a.b.c", "a.b.c.d", "a.x.c" }));
+    CHECK(match("a.b.#") == Names( { "a.b", "a.b.c", "a.b.c.d" }));
+    CHECK(match("*.b.#") == Names( { "a.b", "a.b.c", "a.b.c.d", "b.b.c" }));
+    CHECK(match("#").size() == NAMES.size());
+    CHECK(match("a.c").empty());
+    CHECK(match("c.#").empty());
+}
+
+/**
+ * `#` is only allowed as the last level.
+ */
+static void testInvalidPattern() {
+    Fixture fixture;
+    std::vector<std::string> attached;
+    bool thrown = false;
+    try {
+        fixture.addPattern("a.#.c", attached);
+    } catch (const std::logic_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(attached.empty());
+}
+
+/**
+ * Channels added after a pattern are attached once if they match, and not
+ * after the pattern is removed.
+ */
+static void testLaterChannels() {
+    Fixture fixture;
+    std::vector<std::string> attached;
+    int id = fixture.addPattern("x.*", attached);
+    CHECK(attached.empty());
+
+    Channel<int> xy("test.trie.x.y");
+    Channel<int> xyz("test.trie.x.y.z");
+    fixture.topics.addChannel("x.y", typeid(int), xy);
+    fixture.topics.addChannel("x.y.z", typeid(int), xyz);
+    CHECK(attached == std::vector<std::string>( { "x.y" }));
+
+    fixture.topics.removePattern("x.*", id);
+    Channel<int> xw("test.trie.x.w");
+    fixture.topics.addChannel("x.w", typeid(int), xw);
+    CHECK(attached == std::vector<std::string>( { "x.y" }));
+}
+
+/**
+ * Names are split into levels at the dots.
+ */
+static void testSplit() {
+    CHECK(TopicTrie::split("a.b.c") == std::vector<std::string>( { "a", "b", "c" }));
+    CHECK(TopicTrie::split("a") == std::vector<std::string>( { "a" }));
+}
+
+int main() {
+    testMatching();
+    testInvalidPattern();
+    testLaterChannels();
+    testSplit();
+    return test::finish("topic_trie");
+}